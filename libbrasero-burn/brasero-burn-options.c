@@ -344,6 +344,45 @@ brasero_burn_options_setup_buttons (BraseroBurnOptions *self)
 	brasero_track_type_free (type);
 }
 
+static guint
+brasero_burn_options_span_disc_num (BraseroBurnOptions *self,
+				    goffset available_space)
+{
+	BraseroBurnOptionsPrivate *priv;
+	GSList *tracks;
+
+	priv = BRASERO_BURN_OPTIONS_PRIVATE (self);
+
+	tracks = brasero_burn_session_get_tracks (BRASERO_BURN_SESSION (priv->session));
+	for (; tracks; tracks = tracks->next) {
+		GArray *fill_ratios = NULL;
+		guint num;
+		guint i;
+
+		if (!BRASERO_IS_TRACK_DATA_CFG (tracks->data))
+			continue;
+
+		if (brasero_track_data_cfg_span_get_plan (BRASERO_TRACK_DATA_CFG (tracks->data),
+							  available_space,
+							  &fill_ratios) != BRASERO_BURN_RETRY) {
+			if (fill_ratios)
+				g_array_free (fill_ratios, TRUE);
+			return 0;
+		}
+
+		for (i = 0; i < fill_ratios->len; i ++)
+			BRASERO_BURN_LOG ("Disc %i would be %.1f%% full",
+					  i + 1,
+					  g_array_index (fill_ratios, gdouble, i) * 100.0);
+
+		num = fill_ratios->len;
+		g_array_free (fill_ratios, TRUE);
+		return num;
+	}
+
+	return 0;
+}
+
 static void
 brasero_burn_options_update_valid (BraseroBurnOptions *self)
 {
@@ -421,12 +460,24 @@ brasero_burn_options_update_valid (BraseroBurnOptions *self)
 		if (available_space > min_disc_size
 		&&  brasero_session_span_possible (BRASERO_SESSION_SPAN (priv->session)) == BRASERO_BURN_RETRY) {
 			GtkWidget *message;
+			gchar *secondary;
+			guint disc_num;
+
+			disc_num = brasero_burn_options_span_disc_num (self, available_space);
+			if (disc_num > 1)
+				secondary = g_strdup_printf (ngettext ("The data size is too large for the disc even with the overburn option. It can be burnt across %i disc.",
+								       "The data size is too large for the disc even with the overburn option. It can be burnt across %i discs.",
+								       disc_num),
+							     disc_num);
+			else
+				secondary = g_strdup (_("The data size is too large for the disc even with the overburn option."));
 
 			message = brasero_notify_message_add (priv->message_output,
 							      _("Would you like to burn the selection of files across several media?"),
-							      _("The data size is too large for the disc even with the overburn option."),
+							      secondary,
 							      -1,
 							      BRASERO_NOTIFY_CONTEXT_SIZE);
+			g_free (secondary);
 
 			gtk_widget_set_tooltip_text (gtk_info_bar_add_button (GTK_INFO_BAR (message),
 									      _("_Burn Several Discs"),
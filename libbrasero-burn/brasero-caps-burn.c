@@ -542,7 +542,8 @@ brasero_caps_add_processing_plugins_to_task (BraseroBurnSession *session,
 					     BraseroTask *task,
 					     BraseroCaps *caps,
 					     BraseroTrackType *io_type,
-					     BraseroPluginProcessFlag position)
+					     BraseroPluginProcessFlag position,
+					     BraseroPluginProcessFlag excluded)
 {
 	GSList *retval = NULL;
 	GSList *modifiers;
@@ -559,7 +560,8 @@ brasero_caps_add_processing_plugins_to_task (BraseroBurnSession *session,
 
 	/* Go through all plugins and add all possible modifiers. They must:
 	 * - be active
-	 * - accept the position flags */
+	 * - accept the position flags
+	 * - not accept any of the excluded flags */
 	modifiers = g_slist_copy (caps->modifiers);
 	modifiers = g_slist_sort (modifiers, brasero_burn_caps_sort_modifiers);
 
@@ -577,6 +579,9 @@ brasero_caps_add_processing_plugins_to_task (BraseroBurnSession *session,
 		if ((flags & position) != position)
 			continue;
 
+		if (flags & excluded)
+			continue;
+
 		type = brasero_plugin_get_gtype (plugin);
 		job = BRASERO_JOB (g_object_new (type,
 						 "output", io_type,
@@ -769,12 +774,44 @@ brasero_burn_caps_new_task (BraseroBurnCaps *self,
 				&output,
 				sizeof (BraseroTrackType));
 
+		if (!task
+		&&  !iter->next
+		&&  brasero_track_type_get_has_medium (&plugin_output)
+		&&  (node->link->caps->flags & BRASERO_PLUGIN_IO_ACCEPT_PIPE)
+		&&  BRASERO_BURN_SESSION_NO_TMP_FILE (session)) {
+			/* The recorder is fed directly with the input track.
+			 * Modifiers that can also run before the target (like
+			 * the image checksum) are put in front of the recorder
+			 * in the same task. They then read the input once and
+			 * pass it to the recorder through a pipe, instead of
+			 * reading it a first time in a task of their own. Only
+			 * the modifiers that must pre-process the track get a
+			 * task of their own. */
+			result = brasero_caps_add_processing_plugins_to_task (session,
+									      NULL,
+									      node->link->caps,
+									      &plugin_input,
+									      BRASERO_PLUGIN_RUN_PREPROCESSING,
+									      BRASERO_PLUGIN_RUN_BEFORE_TARGET);
+			retval = g_slist_concat (retval, result);
+
+			BRASERO_BURN_LOG ("New task (recorder fed by modifiers)");
+			task = BRASERO_TASK (g_object_new (BRASERO_TYPE_TASK,
+							   "session", session,
+							   "action", BRASERO_TASK_ACTION_NORMAL,
+							   NULL));
+			retval = g_slist_append (retval, task);
+
+			position = BRASERO_PLUGIN_RUN_BEFORE_TARGET;
+		}
+
 		/* first see if there are track processing plugins */
 		result = brasero_caps_add_processing_plugins_to_task (session,
 								      task,
 								      node->link->caps,
 								      &plugin_input,
-								      position);
+								      position,
+								      BRASERO_PLUGIN_RUN_NEVER);
 		retval = g_slist_concat (retval, result);
 
 		/* Create an object from the plugin */
@@ -820,7 +857,8 @@ brasero_burn_caps_new_task (BraseroBurnCaps *self,
 							    NULL,
 							    last_caps,
 							    &output,
-							    BRASERO_PLUGIN_RUN_AFTER_TARGET);
+							    BRASERO_PLUGIN_RUN_AFTER_TARGET,
+							    BRASERO_PLUGIN_RUN_NEVER);
 	retval = g_slist_concat (retval, list);
 
 	if (brasero_track_type_get_has_medium (&last_caps->type) && blanking) {
@@ -61,7 +61,10 @@ struct _BraseroDataProjectPrivate
 	GCompareFunc sort_func;
 	GtkSortType sort_type;
 
-	GSList *spanned;
+	/* Spanned nodes (BRASERO_DATA_PROJECT_SPANNED) and their parents
+	 * (BRASERO_DATA_PROJECT_SPAN_SPLIT) */
+	GHashTable *spanned;
+	guint span_split_depth;
 
 	/**
 	 * In this table we record all changes (key = URI, data = list
@@ -85,6 +88,11 @@ struct _BraseroDataProjectPrivate
 	/* This is a counter for the number of files to be loaded */
 	guint loading;
 
+	/* Files whose change wasn't signalled yet during a batch */
+	GHashTable *batch_changed;
+	guint batch;
+	guint batch_size_changed:1;
+
 	guint is_loading_contents:1;
 };
 
@@ -591,39 +599,29 @@ brasero_data_project_node_to_uri (BraseroDataProject *self,
 	return retval;
 }
 			  
+/**
+ * names is a path whose separators were replaced by NUL characters (see
+ * below); end points to its terminating NUL character. This way the path is
+ * only split once whatever the number of grafted nodes it is looked for from.
+ */
+
 static BraseroFileNode *
 brasero_data_project_find_child_node (BraseroFileNode *node,
-				      const gchar *path)
+				      const gchar *names,
+				      const gchar *end)
 {
-	gchar *end;
-	guint len;
-
 	/* skip the separator if any */
-	if (path [0] == G_DIR_SEPARATOR)
-		path ++;
-
-	/* find the next separator if any */
-	end = g_utf8_strchr (path, -1, G_DIR_SEPARATOR);
-
-	if (end)
-		len = end - path;
-	else
-		len = strlen (path);
-
-	/* go through the children nodes and find the name */
-	for (node = BRASERO_FILE_NODE_CHILDREN (node); node; node = node->next) {
-		if (node
-		&& !strncmp (BRASERO_FILE_NODE_NAME (node), path, len)
-		&& (BRASERO_FILE_NODE_NAME (node) [len] == G_DIR_SEPARATOR
-		||  BRASERO_FILE_NODE_NAME (node) [len] == '\0')) {
-			if (end)
-				return brasero_data_project_find_child_node (node, end);
-
-			return node;
-		}	
+	if (names < end && names [0] == '\0')
+		names ++;
+
+	/* find each name among the children nodes (they are indexed by name
+	 * for big directories) */
+	while (node && names <= end) {
+		node = brasero_file_node_check_name_existence (node, names);
+		names += strlen (names) + 1;
 	}
 
-	return NULL;
+	return node;
 }
 
 static GSList *
@@ -636,6 +634,8 @@ brasero_data_project_uri_to_nodes (BraseroDataProject *self,
 	gchar *parent;
 	GSList *iter;
 	gchar *path;
+	gchar *end;
+	gchar *ptr;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
@@ -665,13 +665,23 @@ brasero_data_project_uri_to_nodes (BraseroDataProject *self,
 
 	/* unescape URI */
 	path = g_uri_unescape_string (uri, NULL);
+	if (!path)
+		return NULL;
+
+	/* split the path in place */
+	for (ptr = path; *ptr; ptr ++) {
+		if (*ptr == G_DIR_SEPARATOR)
+			*ptr = '\0';
+	}
+	end = ptr;
+
 	for (iter = graft->nodes; iter; iter = iter->next) {
 		BraseroFileNode *node;
 
 		node = iter->data;
 
 		/* find the child node starting from the grafted node */
-		node = brasero_data_project_find_child_node (node, path);
+		node = brasero_data_project_find_child_node (node, path, end);
 		if (node)
 			nodes = g_slist_prepend (nodes, node);
 	}
@@ -680,6 +690,124 @@ brasero_data_project_uri_to_nodes (BraseroDataProject *self,
 	return nodes;
 }
 
+/**
+ * Batches of changes
+ * While a batch is open, the size-changed signal and the changes of files are
+ * not signalled right away. The size-changed signal is emitted once when the
+ * batch is committed and every file that changed (maybe several times) is
+ * signalled once. Changes to directories are still signalled right away since
+ * GtkTreeModel rows (like the empty row) depend on them.
+ */
+
+static void
+brasero_data_project_size_changed (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	if (priv->batch) {
+		priv->batch_size_changed = TRUE;
+		return;
+	}
+
+	g_signal_emit (self,
+		       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
+		       0);
+}
+
+static void
+brasero_data_project_flush_changes (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+	BraseroDataProjectClass *klass;
+	GHashTableIter iter;
+	gpointer node;
+	GSList *nodes;
+	GSList *list;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	if (!priv->batch_changed || !g_hash_table_size (priv->batch_changed))
+		return;
+
+	/* NOTE: the table is emptied before signalling as a handler could
+	 * change more nodes */
+	nodes = NULL;
+	g_hash_table_iter_init (&iter, priv->batch_changed);
+	while (g_hash_table_iter_next (&iter, &node, NULL))
+		nodes = g_slist_prepend (nodes, node);
+
+	g_hash_table_remove_all (priv->batch_changed);
+
+	klass = BRASERO_DATA_PROJECT_GET_CLASS (self);
+	if (klass->node_changed) {
+		for (list = nodes; list; list = list->next)
+			klass->node_changed (self, list->data);
+	}
+
+	g_slist_free (nodes);
+}
+
+/* Batches can be nested; changes are signalled when the outermost one is
+ * committed. */
+
+void
+brasero_data_project_begin_batch (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	g_return_if_fail (BRASERO_IS_DATA_PROJECT (self));
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	priv->batch ++;
+}
+
+void
+brasero_data_project_commit_batch (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	g_return_if_fail (BRASERO_IS_DATA_PROJECT (self));
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	g_return_if_fail (priv->batch > 0);
+
+	priv->batch --;
+	if (priv->batch)
+		return;
+
+	brasero_data_project_flush_changes (self);
+
+	if (priv->batch_size_changed) {
+		priv->batch_size_changed = FALSE;
+		g_signal_emit (self,
+			       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
+			       0);
+	}
+}
+
+/* Same as commit but the pending changes are dropped without being signalled;
+ * meant for objects being destroyed. */
+
+void
+brasero_data_project_discard_batch (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	g_return_if_fail (BRASERO_IS_DATA_PROJECT (self));
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	g_return_if_fail (priv->batch > 0);
+
+	priv->batch --;
+	if (priv->batch)
+		return;
+
+	if (priv->batch_changed)
+		g_hash_table_remove_all (priv->batch_changed);
+
+	priv->batch_size_changed = FALSE;
+}
+
 /**
  * Sorting
  * DataProject must be the one to handle that:
@@ -698,7 +826,13 @@ brasero_data_project_node_changed (BraseroDataProject *self,
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 	klass = BRASERO_DATA_PROJECT_GET_CLASS (self);
 
-	if (klass->node_changed)
+	if (priv->batch && node->is_file) {
+		if (!priv->batch_changed)
+			priv->batch_changed = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+		g_hash_table_insert (priv->batch_changed, node, node);
+	}
+	else if (klass->node_changed)
 		klass->node_changed (self, node);
 
 	array = brasero_file_node_need_resort (node, priv->sort_func);
@@ -1134,6 +1268,9 @@ brasero_data_project_node_removed (BraseroDataProject *self,
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
+	/* The node and its children are about to be destroyed */
+	brasero_data_project_flush_changes (self);
+
 #ifdef BUILD_INOTIFY
 
 	/* remove all monitoring */
@@ -1236,9 +1373,7 @@ brasero_data_project_remove_real (BraseroDataProject *self,
 						 former_parent,
 						 priv->sort_func);
 
-	g_signal_emit (self,
-		       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-		       0);
+	brasero_data_project_size_changed (self);
 }
 
 static void
@@ -1336,9 +1471,7 @@ brasero_data_project_destroy_node (BraseroDataProject *self,
 	stats = brasero_file_node_get_tree_stats (priv->root, NULL);
 	brasero_file_node_destroy (node, stats);
 
-	g_signal_emit (self,
-		       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-		       0);
+	brasero_data_project_size_changed (self);
 
 	/* NOTE: no need to check for imported_sibling here since this function
 	 * actually destroys all nodes including imported ones and is mainly 
@@ -1509,6 +1642,8 @@ brasero_data_project_move_node (BraseroDataProject *self,
 	 * - new location addition */
 
 	/* unparent node now in case its target sibling is a parent */
+	brasero_data_project_flush_changes (self);
+
 	former_parent = node->parent;
 	former_position = brasero_file_node_get_pos_as_child (node);
 	stats = brasero_file_node_get_tree_stats (priv->root, NULL);
@@ -1841,12 +1976,7 @@ brasero_data_project_add_imported_session_file (BraseroDataProject *self,
 			&&  !brasero_data_project_uri_has_parent (self, uri_node->uri))
 				brasero_data_project_uri_remove_graft (self, uri_node->uri);
 
-			if (sibling->is_file)
-				sibling->is_fake = FALSE;
-			else
-				sibling->union3.imported_address = g_file_info_get_attribute_int64 (info, BRASERO_IO_DIR_CONTENTS_ADDR);
-
-			sibling->is_imported = TRUE;
+			brasero_file_node_set_imported (sibling, g_file_info_get_attribute_int64 (info, BRASERO_IO_DIR_CONTENTS_ADDR));
 			sibling->is_tmp_parent = FALSE;
 
 			/* Something has changed, tell the tree */
@@ -2103,9 +2233,7 @@ brasero_data_project_node_loaded (BraseroDataProject *self,
 	/* signal the changes */
 	brasero_data_project_node_changed (self, node);
 	if (size_changed)
-		g_signal_emit (self,
-			       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-			       0);
+		brasero_data_project_size_changed (self);
 
 	return TRUE;
 }
@@ -2157,9 +2285,7 @@ brasero_data_project_node_reloaded (BraseroDataProject *self,
 
 	brasero_data_project_node_changed (self, node);
 	if (size_changed)
-		g_signal_emit (self,
-			       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-			       0);
+		brasero_data_project_size_changed (self);
 }
 
 static BraseroFileNode *
@@ -2426,9 +2552,7 @@ brasero_data_project_add_node_from_info (BraseroDataProject *self,
 	}
 
 	if (type != G_FILE_TYPE_DIRECTORY)
-		g_signal_emit (self,
-			       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-			       0);
+		brasero_data_project_size_changed (self);
 
 	/* at this point we know all we need to know about our node and in 
 	 * particular if it's a file or a directory, if it's grafted or not
@@ -2473,47 +2597,43 @@ gchar *
 brasero_data_project_node_to_path (BraseroDataProject *self,
 				   BraseroFileNode *node)
 {
+	BraseroFileNode *iter;
+	gchar *path;
+	gchar *ptr;
 	guint len;
-	GSList *list;
-	GSList *iter;
-	gchar path [MAXPATHLEN] = {0, };
 
 	if (!node || G_NODE_IS_ROOT (node))
 		return g_strdup (G_DIR_SEPARATOR_S);
 
-	/* walk the nodes up to the parent and add them to a list */
-	list = NULL;
-	while (node->parent) {
-		list = g_slist_prepend (list, node);
-		node = node->parent;
-	}
-
+	/* walk the nodes up to the root a first time to get the length and
+	 * make sure path length doesn't go over MAXPATHLEN. */
 	len = 0;
-	for (iter = list; iter; iter = iter->next) {
-		gchar *name;
-		guint name_len;
-
-		node = iter->data;
-
-		*(path + len) = G_DIR_SEPARATOR;
-		len ++;
-
+	for (iter = node; iter->parent; iter = iter->parent) {
+		len += strlen (BRASERO_FILE_NODE_NAME (iter)) + 1;
 		if (len > MAXPATHLEN)
 			return NULL;
+	}
+
+	/* then fill the path from its end */
+	path = g_new (gchar, len + 1);
+	ptr = path + len;
+	*ptr = '\0';
 
-		/* Make sure path length didn't go over MAXPATHLEN. */
-		name = BRASERO_FILE_NODE_NAME (node);
+	for (iter = node; iter->parent; iter = iter->parent) {
+		gchar *name;
+		guint name_len;
 
+		name = BRASERO_FILE_NODE_NAME (iter);
 		name_len = strlen (name);
-		if (len + name_len > MAXPATHLEN)
-			return NULL;
 
-		memcpy (path + len, name, name_len);
-		len += name_len;
+		ptr -= name_len;
+		memcpy (ptr, name, name_len);
+
+		ptr --;
+		*ptr = G_DIR_SEPARATOR;
 	}
-	g_slist_free (list);
 
-	return g_strdup (path);
+	return path;
 }
 
 static void
@@ -2850,12 +2970,226 @@ brasero_data_project_improve_image_size_accuracy (goffset sectors,
 	return sectors;
 }
 
+/**
+ * Spanning: the top level files and directories are packed on discs. When a
+ * directory is too big for a disc and is not deeper than span_split_depth,
+ * its children are packed instead (this is disabled by default; the depth
+ * comes from the span-split-depth setting).
+ * Each time a new disc is requested, the whole assignment of the remaining
+ * files and directories to discs is planned with a first fit decreasing
+ * heuristic. Then the first disc of the plan (which is also the fullest) is
+ * used. First fit decreasing is deterministic so planning again for the next
+ * disc gives the rest of the plan (unless the size of the disc changed).
+ */
+
+#define BRASERO_DATA_PROJECT_SPANNED		GINT_TO_POINTER (1)
+#define BRASERO_DATA_PROJECT_SPAN_SPLIT		GINT_TO_POINTER (2)
+
+typedef struct _BraseroDataProjectSpanItem BraseroDataProjectSpanItem;
+struct _BraseroDataProjectSpanItem {
+	BraseroFileNode *node;
+	goffset sectors;
+};
+
+typedef struct _BraseroDataProjectSpanDisc BraseroDataProjectSpanDisc;
+struct _BraseroDataProjectSpanDisc {
+	GSList *items;
+	goffset sectors;
+};
+
+static GSList *
+brasero_data_project_span_get_items (BraseroDataProject *self,
+				     BraseroFileNode *parent,
+				     guint depth,
+				     goffset max_sectors,
+				     GSList *items)
+{
+	BraseroDataProjectPrivate *priv;
+	BraseroFileNode *node;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	for (node = BRASERO_FILE_NODE_CHILDREN (parent); node; node = node->next) {
+		BraseroDataProjectSpanItem *item;
+		gpointer status = NULL;
+		goffset sectors;
+
+		if (priv->spanned)
+			status = g_hash_table_lookup (priv->spanned, node);
+
+		if (status == BRASERO_DATA_PROJECT_SPANNED)
+			continue;
+
+		if (node->is_file)
+			sectors = BRASERO_FILE_NODE_SECTORS (node);
+		else
+			sectors = brasero_data_project_get_folder_sectors (self, node);
+
+		/* If part of this directory was already written, only the
+		 * rest of it can go on the next discs. Otherwise split it if
+		 * it is too big and that is allowed. */
+		if (status == BRASERO_DATA_PROJECT_SPAN_SPLIT
+		|| (!node->is_file
+		&&   sectors > max_sectors
+		&&   depth < priv->span_split_depth
+		&&   BRASERO_FILE_NODE_CHILDREN (node))) {
+			items = brasero_data_project_span_get_items (self,
+								     node,
+								     depth + 1,
+								     max_sectors,
+								     items);
+			continue;
+		}
+
+		item = g_new0 (BraseroDataProjectSpanItem, 1);
+		item->node = node;
+		item->sectors = sectors;
+		items = g_slist_prepend (items, item);
+	}
+
+	return items;
+}
+
+static void
+brasero_data_project_span_free_items (GSList *items)
+{
+	g_slist_foreach (items, (GFunc) g_free, NULL);
+	g_slist_free (items);
+}
+
+static gint
+brasero_data_project_span_sort_items (gconstpointer a,
+				      gconstpointer b)
+{
+	const BraseroDataProjectSpanItem *item_a = a;
+	const BraseroDataProjectSpanItem *item_b = b;
+
+	/* Biggest first */
+	if (item_a->sectors > item_b->sectors)
+		return -1;
+
+	if (item_a->sectors < item_b->sectors)
+		return 1;
+
+	return 0;
+}
+
+static void
+brasero_data_project_span_free_plan (GSList *discs)
+{
+	GSList *iter;
+
+	for (iter = discs; iter; iter = iter->next) {
+		BraseroDataProjectSpanDisc *disc;
+
+		disc = iter->data;
+		g_slist_free (disc->items);
+		g_free (disc);
+	}
+	g_slist_free (discs);
+}
+
+static GSList *
+brasero_data_project_span_plan (GSList *items,
+				goffset max_sectors)
+{
+	GSList *discs = NULL;
+	GSList *iter;
+	guint num = 0;
+
+	/* First fit decreasing: the biggest items are placed first, each on
+	 * the first disc with enough space left */
+	for (iter = items; iter; iter = iter->next) {
+		BraseroDataProjectSpanItem *item;
+		BraseroDataProjectSpanDisc *disc;
+		GSList *disc_iter;
+
+		item = iter->data;
+
+		/* This one can't be spanned */
+		if (item->sectors > max_sectors)
+			continue;
+
+		disc = NULL;
+		for (disc_iter = discs; disc_iter; disc_iter = disc_iter->next) {
+			BraseroDataProjectSpanDisc *candidate;
+
+			candidate = disc_iter->data;
+			if (candidate->sectors + item->sectors <= max_sectors) {
+				disc = candidate;
+				break;
+			}
+		}
+
+		if (!disc) {
+			disc = g_new0 (BraseroDataProjectSpanDisc, 1);
+			discs = g_slist_append (discs, disc);
+		}
+
+		disc->items = g_slist_prepend (disc->items, item);
+		disc->sectors += item->sectors;
+	}
+
+	BRASERO_BURN_LOG ("Spanning plan for discs of %" G_GOFFSET_FORMAT " sectors: %i discs",
+			  max_sectors,
+			  g_slist_length (discs));
+
+	for (iter = discs; iter; iter = iter->next) {
+		BraseroDataProjectSpanDisc *disc;
+
+		disc = iter->data;
+		BRASERO_BURN_LOG ("Disc %i: %i files/directories, %" G_GOFFSET_FORMAT " sectors (%.1f%% full)",
+				  ++ num,
+				  g_slist_length (disc->items),
+				  disc->sectors,
+				  max_sectors ? (gdouble) disc->sectors * 100.0 / (gdouble) max_sectors:0.0);
+	}
+
+	return discs;
+}
+
+static GSList *
+brasero_data_project_span_get_sorted_items (BraseroDataProject *self,
+					    goffset max_sectors)
+{
+	BraseroDataProjectPrivate *priv;
+	GSList *items;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	/* NOTE: the list is reversed to keep the order of the tree for items
+	 * of the same size (sorting is stable) */
+	items = brasero_data_project_span_get_items (self, priv->root, 0, max_sectors, NULL);
+	items = g_slist_reverse (items);
+	return g_slist_sort (items, brasero_data_project_span_sort_items);
+}
+
+static void
+brasero_data_project_span_set_spanned (BraseroDataProject *self,
+				       BraseroFileNode *node)
+{
+	BraseroDataProjectPrivate *priv;
+	BraseroFileNode *parent;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	if (!priv->spanned)
+		priv->spanned = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	g_hash_table_insert (priv->spanned, node, BRASERO_DATA_PROJECT_SPANNED);
+
+	/* Remember that the parents were split */
+	for (parent = node->parent; parent && !parent->is_root; parent = parent->parent)
+		g_hash_table_insert (priv->spanned, parent, BRASERO_DATA_PROJECT_SPAN_SPLIT);
+}
+
 goffset
 brasero_data_project_get_max_space (BraseroDataProject *self)
 {
 	BraseroDataProjectPrivate *priv;
-	BraseroFileNode *children;
 	goffset max_sectors = 0;
+	GSList *items;
+	GSList *iter;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
@@ -2863,23 +3197,15 @@ brasero_data_project_get_max_space (BraseroDataProject *self)
 	if (!g_hash_table_size (priv->grafts))
 		return 0;
 
-	children = BRASERO_FILE_NODE_CHILDREN (priv->root);
-	while (children) {
-		goffset child_sectors;
+	/* Split everything that can be to get the smallest possible size */
+	items = brasero_data_project_span_get_items (self, priv->root, 0, 0, NULL);
+	for (iter = items; iter; iter = iter->next) {
+		BraseroDataProjectSpanItem *item;
 
-		if (g_slist_find (priv->spanned, children)) {
-			children = children->next;
-			continue;
-		}
-
-		if (children->is_file)
-			child_sectors = BRASERO_FILE_NODE_SECTORS (children);
-		else
-			child_sectors = brasero_data_project_get_folder_sectors (self, children);
-
-		max_sectors = MAX (max_sectors, child_sectors);
-		children = children->next;
+		item = iter->data;
+		max_sectors = MAX (max_sectors, item->sectors);
 	}
+	brasero_data_project_span_free_items (items);
 
 	return max_sectors;
 }
@@ -2893,8 +3219,11 @@ brasero_data_project_span (BraseroDataProject *self,
 {
 	MakeTrackDataSpan callback_data;
 	BraseroDataProjectPrivate *priv;
-	BraseroFileNode *children;
+	BraseroDataProjectSpanDisc *disc;
 	goffset total_sectors = 0;
+	GSList *items;
+	GSList *discs;
+	GSList *iter;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
@@ -2910,60 +3239,56 @@ brasero_data_project_span (BraseroDataProject *self,
 	if (joliet)
 		callback_data.fs_type |= BRASERO_IMAGE_FS_JOLIET;
 
-	children = BRASERO_FILE_NODE_CHILDREN (priv->root);
-	while (children) {
-		goffset child_sectors;
+	items = brasero_data_project_span_get_sorted_items (self, max_sectors);
+	discs = brasero_data_project_span_plan (items, max_sectors);
 
-		if (g_slist_find (priv->spanned, children)) {
-			children = children->next;
-			continue;
-		}
+	/* This means it's finished */
+	if (!discs) {
+		brasero_data_project_span_free_items (items);
+		BRASERO_BURN_LOG ("No graft found for spanning");
+		return BRASERO_BURN_OK;
+	}
 
-		if (children->is_file)
-			child_sectors = BRASERO_FILE_NODE_SECTORS (children);
-		else
-			child_sectors = brasero_data_project_get_folder_sectors (self, children);
+	/* Use the first disc of the plan */
+	disc = discs->data;
+	for (iter = disc->items; iter; iter = iter->next) {
+		BraseroDataProjectSpanItem *item;
+		BraseroFileNode *node;
 
-		/* if the top directory is too large, continue */
-		if (child_sectors + total_sectors > max_sectors) {
-			children = children->next;
-			continue;
-		}
+		item = iter->data;
+		node = item->node;
 
-		/* FIXME: we need a better algorithm here that would add first
-		 * the biggest top folders/files and that would try to fill as
-		 * much as possible the disc. */
-		total_sectors += child_sectors;
+		total_sectors += item->sectors;
 
 		/* Take care of joliet non compliant nodes */
 		if (callback_data.fs_type & BRASERO_IMAGE_FS_JOLIET) {
-			GHashTableIter iter;
+			GHashTableIter hiter;
 			gpointer value_data;
 			gpointer key_data;
 
 			/* Problem is we don't know whether there are symlinks */
-			g_hash_table_iter_init (&iter, priv->joliet);
-			while (g_hash_table_iter_next (&iter, &key_data, &value_data)) {
+			g_hash_table_iter_init (&hiter, priv->joliet);
+			while (g_hash_table_iter_next (&hiter, &key_data, &value_data)) {
 				GSList *nodes;
 				BraseroJolietKey *key;
 
 				/* Is the node a graft a child of a graft */
 				key = key_data;
-				if (key->parent == children || brasero_file_node_is_ancestor (children, key->parent)) {
+				if (key->parent == node || brasero_file_node_is_ancestor (node, key->parent)) {
 					/* Add all the children to the list of
 					 * grafts provided they are not already
 					 * grafted. */
 					for (nodes = value_data; nodes; nodes = nodes->next) {
-						BraseroFileNode *node;
+						BraseroFileNode *joliet_node;
 
 						/* skip grafted nodes (they are
 						 * already or will be processed)
 						 */
-						node = nodes->data;
-						if (node->is_grafted)
+						joliet_node = nodes->data;
+						if (joliet_node->is_grafted)
 							continue;
 						
-						callback_data.joliet_grafts = g_slist_prepend (callback_data.joliet_grafts, node);
+						callback_data.joliet_grafts = g_slist_prepend (callback_data.joliet_grafts, joliet_node);
 					}
 
 					break;
@@ -2971,25 +3296,21 @@ brasero_data_project_span (BraseroDataProject *self,
 			}
 		}
 
-		callback_data.grafts = g_slist_prepend (callback_data.grafts, children);
-		if (children->is_file) {
-			brasero_data_project_span_set_fs_type (&callback_data, children);
+		callback_data.grafts = g_slist_prepend (callback_data.grafts, node);
+		if (node->is_file) {
+			brasero_data_project_span_set_fs_type (&callback_data, node);
 			callback_data.files_num ++;
 		}
 		else {
-			brasero_data_project_span_explore_folder_children (&callback_data, children);
+			brasero_data_project_span_explore_folder_children (&callback_data, node);
 			callback_data.dir_num ++;
 		}
 
-		priv->spanned = g_slist_prepend (priv->spanned, children);
-		children = children->next;
+		brasero_data_project_span_set_spanned (self, node);
 	}
 
-	/* This means it's finished */
-	if (!callback_data.grafts) {
-		BRASERO_BURN_LOG ("No graft found for spanning");
-		return BRASERO_BURN_OK;
-	}
+	brasero_data_project_span_free_plan (discs);
+	brasero_data_project_span_free_items (items);
 
 	brasero_data_project_span_generate (self,
 					    &callback_data,
@@ -3017,8 +3338,9 @@ brasero_data_project_span_possible (BraseroDataProject *self,
 				    goffset max_sectors)
 {
 	BraseroDataProjectPrivate *priv;
-	gboolean has_data_left = FALSE;
-	BraseroFileNode *children;
+	BraseroBurnResult result;
+	GSList *items;
+	GSList *iter;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
@@ -3026,40 +3348,81 @@ brasero_data_project_span_possible (BraseroDataProject *self,
 	if (!g_hash_table_size (priv->grafts))
 		return BRASERO_BURN_ERR;
 
-	children = BRASERO_FILE_NODE_CHILDREN (priv->root);
-	while (children) {
-		goffset child_sectors;
+	items = brasero_data_project_span_get_items (self, priv->root, 0, max_sectors, NULL);
+	if (!items)
+		return BRASERO_BURN_OK;
 
-		if (g_slist_find (priv->spanned, children)) {
-			children = children->next;
-			continue;
+	/* Find at least one file or directory that can be spanned */
+	result = BRASERO_BURN_ERR;
+	for (iter = items; iter; iter = iter->next) {
+		BraseroDataProjectSpanItem *item;
+
+		item = iter->data;
+		if (item->sectors <= max_sectors) {
+			result = BRASERO_BURN_RETRY;
+			break;
 		}
+	}
+	brasero_data_project_span_free_items (items);
 
-		if (children->is_file)
-			child_sectors = BRASERO_FILE_NODE_SECTORS (children);
-		else
-			child_sectors = brasero_data_project_get_folder_sectors (self, children);
+	return result;
+}
 
-		/* Find at least one file or directory that can be spanned */
-		if (child_sectors < max_sectors)
-			return BRASERO_BURN_RETRY;
+/**
+ * Fills @fill_ratios with the fill ratio (between 0 and 1) of each disc that
+ * spanning the remaining files and directories on discs of @max_sectors would
+ * use, fullest first (that is, in the order they would be burnt).
+ * Files and directories too big for a disc are not part of the plan.
+ */
 
-		/* if the top directory is too large, continue */
-		children = children->next;
-		has_data_left = TRUE;
-	}
+BraseroBurnResult
+brasero_data_project_span_get_plan (BraseroDataProject *self,
+				    goffset max_sectors,
+				    GArray **fill_ratios)
+{
+	BraseroDataProjectPrivate *priv;
+	GSList *items;
+	GSList *discs;
+	GSList *iter;
+	guint num;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
-	if (has_data_left)
+	/* When empty this is an error */
+	if (!g_hash_table_size (priv->grafts) || max_sectors <= 0)
 		return BRASERO_BURN_ERR;
 
-	return BRASERO_BURN_OK;
+	items = brasero_data_project_span_get_sorted_items (self, max_sectors);
+	discs = brasero_data_project_span_plan (items, max_sectors);
+	num = g_slist_length (discs);
+
+	if (fill_ratios) {
+		*fill_ratios = g_array_sized_new (FALSE,
+						  FALSE,
+						  sizeof (gdouble),
+						  num);
+
+		for (iter = discs; iter; iter = iter->next) {
+			BraseroDataProjectSpanDisc *disc;
+			gdouble ratio;
+
+			disc = iter->data;
+			ratio = (gdouble) disc->sectors / (gdouble) max_sectors;
+			g_array_append_val (*fill_ratios, ratio);
+		}
+	}
+
+	brasero_data_project_span_free_plan (discs);
+	brasero_data_project_span_free_items (items);
+
+	return num? BRASERO_BURN_RETRY:BRASERO_BURN_OK;
 }
 
 BraseroBurnResult
 brasero_data_project_span_again (BraseroDataProject *self)
 {
 	BraseroDataProjectPrivate *priv;
-	BraseroFileNode *children;
+	GSList *items;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
@@ -3067,12 +3430,11 @@ brasero_data_project_span_again (BraseroDataProject *self)
 	if (!g_hash_table_size (priv->grafts))
 		return BRASERO_BURN_ERR;
 
-	children = BRASERO_FILE_NODE_CHILDREN (priv->root);
-	while (children) {
-		if (!g_slist_find (priv->spanned, children))
-			return BRASERO_BURN_RETRY;
-
-		children = children->next;
+	/* Don't split anything more; only see if something is left */
+	items = brasero_data_project_span_get_items (self, priv->root, 0, G_MAXINT64, NULL);
+	if (items) {
+		brasero_data_project_span_free_items (items);
+		return BRASERO_BURN_RETRY;
 	}
 
 	return BRASERO_BURN_OK;
@@ -3084,8 +3446,20 @@ brasero_data_project_span_stop (BraseroDataProject *self)
 	BraseroDataProjectPrivate *priv;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
-	g_slist_free (priv->spanned);
-	priv->spanned = NULL;
+	if (priv->spanned) {
+		g_hash_table_destroy (priv->spanned);
+		priv->spanned = NULL;
+	}
+}
+
+void
+brasero_data_project_set_span_split_depth (BraseroDataProject *self,
+					   guint depth)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	priv->span_split_depth = depth;
 }
 
 gboolean
@@ -3557,9 +3931,11 @@ brasero_data_project_load_contents_notify (BraseroDataProject *self)
 	/* we'll notify for every single node in the tree starting from the top.
 	 * NOTE: at this point there are only grafted nodes (fake or not) in the
 	 * tree. */
+	brasero_data_project_begin_batch (self);
 	num = brasero_data_project_load_contents_notify_directory (self,
 								   priv->root,
 								   klass->node_added);
+	brasero_data_project_commit_batch (self);
 	return num;
 }
 
@@ -3705,52 +4081,16 @@ brasero_data_project_get_sectors (BraseroDataProject *self)
 	return retval;
 }
 
-struct _BraseroFileSize {
-	goffset sum;
-	BraseroFileNode *node;
-};
-typedef struct _BraseroFileSize BraseroFileSize;
-
-static void
-brasero_data_project_folder_size_cb (const gchar *uri,
-				     BraseroURINode *graft,
-				     BraseroFileSize *size)
-{
-	GSList *iter;
-
-	for (iter = graft->nodes; iter; iter = iter->next) {
-		BraseroFileNode *node;
-
-		node = iter->data;
-		if (node == size->node)
-			continue;
-
-		if (brasero_file_node_is_ancestor (size->node, node)) {
-			size->sum += BRASERO_FILE_NODE_SECTORS (node);
-			return;
-		}
-	}
-}
-
 goffset
 brasero_data_project_get_folder_sectors (BraseroDataProject *self,
 					 BraseroFileNode *node)
 {
-	BraseroDataProjectPrivate *priv;
-	BraseroFileSize size;
-
 	if (node->is_file)
 		return 0;
 
-	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
-
-	size.node = node;
-	size.sum = BRASERO_FILE_NODE_SECTORS (node);
-
-	g_hash_table_foreach (priv->grafts,
-			      (GHFunc) brasero_data_project_folder_size_cb,
-			      &size);
-	return size.sum;
+	/* Each directory keeps the size of its whole subtree (grafts
+	 * included) up to date so there is no need to look for grafts */
+	return BRASERO_FILE_NODE_TOTAL_SECTORS (node);
 }
 
 static void
@@ -3867,7 +4207,7 @@ brasero_data_project_clear (BraseroDataProject *self)
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
 	if (priv->spanned) {
-		g_slist_free (priv->spanned);
+		g_hash_table_destroy (priv->spanned);
 		priv->spanned = NULL;
 	}
 
@@ -3884,6 +4224,10 @@ brasero_data_project_clear (BraseroDataProject *self)
 	g_hash_table_destroy (priv->reference);
 	priv->reference = g_hash_table_new (g_direct_hash, g_direct_equal);
 
+	/* The nodes are destroyed: there is nothing to signal */
+	if (priv->batch_changed)
+		g_hash_table_remove_all (priv->batch_changed);
+
 	/* no need to give a stats since we're destroying it */
 	brasero_file_node_destroy (priv->root, NULL);
 	priv->root = NULL;
@@ -3939,6 +4283,11 @@ brasero_data_project_finalize (GObject *object)
 		priv->reference = NULL;
 	}
 
+	if (priv->batch_changed) {
+		g_hash_table_destroy (priv->batch_changed);
+		priv->batch_changed = NULL;
+	}
+
 	G_OBJECT_CLASS (brasero_data_project_parent_class)->finalize (object);
 }
 
@@ -4261,6 +4610,8 @@ brasero_data_project_file_moved (BraseroFileMonitor *monitor,
 		sibling = brasero_file_node_check_imported_sibling (node);
 
 		/* move it */
+		brasero_data_project_flush_changes (BRASERO_DATA_PROJECT (monitor));
+
 		former_parent = node->parent;
 		former_position = brasero_file_node_get_pos_as_child (node);
 
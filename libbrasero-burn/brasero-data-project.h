@@ -122,6 +122,15 @@ GType brasero_data_project_get_type (void) G_GNUC_CONST;
 void
 brasero_data_project_reset (BraseroDataProject *project);
 
+void
+brasero_data_project_begin_batch (BraseroDataProject *project);
+
+void
+brasero_data_project_commit_batch (BraseroDataProject *project);
+
+void
+brasero_data_project_discard_batch (BraseroDataProject *project);
+
 goffset
 brasero_data_project_get_sectors (BraseroDataProject *project);
 
@@ -261,12 +270,21 @@ brasero_data_project_span_again (BraseroDataProject *project);
 BraseroBurnResult
 brasero_data_project_span_possible (BraseroDataProject *project,
 				    goffset max_sectors);
+
+BraseroBurnResult
+brasero_data_project_span_get_plan (BraseroDataProject *project,
+				    goffset max_sectors,
+				    GArray **fill_ratios);
 goffset
 brasero_data_project_get_max_space (BraseroDataProject *self);
 
 void
 brasero_data_project_span_stop (BraseroDataProject *project);
 
+void
+brasero_data_project_set_span_split_depth (BraseroDataProject *project,
+					   guint depth);
+
 G_END_DECLS
 
 #endif /* _BRASERO_DATA_PROJECT_H_ */
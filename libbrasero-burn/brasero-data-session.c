@@ -43,6 +43,8 @@
 #include "brasero-medium.h"
 #include "brasero-medium-monitor.h"
 #include "burn-volume.h"
+#include "burn-volume-index.h"
+#include "burn-debug.h"
 
 #include "brasero-burn-lib.h"
 
@@ -53,11 +55,30 @@
 
 #include "libbrasero-marshal.h"
 
+/**
+ * Shared between the session and the jobs loading directories. The index of
+ * the whole session is created by the first job so that the following ones
+ * don't need to access the medium.
+ */
+struct _BraseroDataSessionIndex {
+	GMutex *lock;
+	BraseroVolIndex *index;
+	gint ref;
+
+	/* Set when the session could not be indexed so that it is not tried
+	 * again for every directory */
+	guint failed:1;
+};
+typedef struct _BraseroDataSessionIndex BraseroDataSessionIndex;
+
 typedef struct _BraseroDataSessionPrivate BraseroDataSessionPrivate;
 struct _BraseroDataSessionPrivate
 {
 	BraseroIOJobBase *load_dir;
 
+	/* Index of the loaded session */
+	BraseroDataSessionIndex *index;
+
 	/* Multisession drives that are inserted */
 	GSList *media;
 
@@ -89,9 +110,71 @@ struct _BraseroIOImageContentsData {
 
 	gint64 session_block;
 	gint64 block;
+
+	BraseroDataSessionIndex *index;
 };
 typedef struct _BraseroIOImageContentsData BraseroIOImageContentsData;
 
+static BraseroDataSessionIndex *
+brasero_data_session_index_new (void)
+{
+	BraseroDataSessionIndex *index;
+
+	index = g_new0 (BraseroDataSessionIndex, 1);
+	index->lock = g_mutex_new ();
+	index->ref = 1;
+	return index;
+}
+
+static BraseroDataSessionIndex *
+brasero_data_session_index_ref (BraseroDataSessionIndex *index)
+{
+	g_atomic_int_inc (&index->ref);
+	return index;
+}
+
+static void
+brasero_data_session_index_unref (BraseroDataSessionIndex *index)
+{
+	if (!g_atomic_int_dec_and_test (&index->ref))
+		return;
+
+	if (index->index)
+		brasero_volume_index_unref (index->index);
+
+	g_mutex_free (index->lock);
+	g_free (index);
+}
+
+/**
+ * Returns a reference on the index of the session, creating it if needed
+ * (unless vol is NULL).
+ * NOTE: this is called from a thread.
+ */
+
+static BraseroVolIndex *
+brasero_data_session_index_get (BraseroDataSessionIndex *index,
+				BraseroVolSrc *vol,
+				gint64 session_block)
+{
+	BraseroVolIndex *retval = NULL;
+
+	g_mutex_lock (index->lock);
+	if (!index->index && !index->failed && vol) {
+		index->index = brasero_volume_index_new (vol, session_block, NULL);
+		if (!index->index) {
+			BRASERO_BURN_LOG ("Session could not be indexed; directories will be read one by one");
+			index->failed = TRUE;
+		}
+	}
+
+	if (index->index)
+		retval = brasero_volume_index_ref (index->index);
+	g_mutex_unlock (index->lock);
+
+	return retval;
+}
+
 static void
 brasero_io_image_directory_contents_destroy (BraseroAsyncTaskManager *manager,
 					     gboolean cancelled,
@@ -99,10 +182,64 @@ brasero_io_image_directory_contents_destroy (BraseroAsyncTaskManager *manager,
 {
 	BraseroIOImageContentsData *data = callback_data;
 
+	if (data->index)
+		brasero_data_session_index_unref (data->index);
+
 	g_free (data->dev_image);
 	brasero_io_job_free (cancelled, BRASERO_IO_JOB (data));
 }
 
+static void
+brasero_io_image_directory_contents_return (BraseroIOImageContentsData *data,
+					    GList *children)
+{
+	GList *iter;
+
+	for (iter = children; iter; iter = iter->next) {
+		BraseroVolFile *file;
+		GFileInfo *info;
+
+		file = iter->data;
+
+		info = g_file_info_new ();
+		g_file_info_set_file_type (info, file->isdir? G_FILE_TYPE_DIRECTORY:G_FILE_TYPE_REGULAR);
+		g_file_info_set_name (info, BRASERO_VOLUME_FILE_NAME (file));
+
+		if (file->isdir)
+			g_file_info_set_attribute_int64 (info,
+							 BRASERO_IO_DIR_CONTENTS_ADDR,
+							 file->specific.dir.address);
+		else
+			g_file_info_set_size (info, BRASERO_VOLUME_FILE_SIZE (file));
+
+		brasero_io_return_result (data->job.base,
+					  data->job.uri,
+					  info,
+					  NULL,
+					  data->job.callback_data);
+	}
+}
+
+/* Returns FALSE if the directory is not in the index; its contents must then
+ * be read from the medium. */
+static gboolean
+brasero_io_image_directory_contents_from_index (BraseroIOImageContentsData *data,
+						BraseroVolIndex *index)
+{
+	BraseroVolFile *directory;
+
+	directory = brasero_volume_index_get_directory (index, data->block);
+	brasero_volume_index_unref (index);
+
+	if (!directory) {
+		BRASERO_BURN_LOG ("Directory at %lli is not indexed", data->block);
+		return FALSE;
+	}
+
+	brasero_io_image_directory_contents_return (data, directory->specific.dir.children);
+	return TRUE;
+}
+
 static BraseroAsyncTaskResult
 brasero_io_image_directory_contents_thread (BraseroAsyncTaskManager *manager,
 					    GCancellable *cancel,
@@ -110,9 +247,17 @@ brasero_io_image_directory_contents_thread (BraseroAsyncTaskManager *manager,
 {
 	BraseroIOImageContentsData *data = callback_data;
 	BraseroDeviceHandle *handle;
-	GList *children, *iter;
+	BraseroVolIndex *index;
 	GError *error = NULL;
 	BraseroVolSrc *vol;
+	GList *children;
+
+	/* No need to access the medium if the session was already indexed */
+	if (data->index) {
+		index = brasero_data_session_index_get (data->index, NULL, 0);
+		if (index && brasero_io_image_directory_contents_from_index (data, index))
+			return BRASERO_ASYNC_TASK_FINISHED;
+	}
 
 	handle = brasero_device_handle_open (data->job.uri, FALSE, NULL);
 	if (!handle) {
@@ -140,6 +285,26 @@ brasero_io_image_directory_contents_thread (BraseroAsyncTaskManager *manager,
 					  data->job.callback_data);
 		return BRASERO_ASYNC_TASK_FINISHED;
 	}
+	else {
+		BraseroVolSrc *cache;
+
+		/* Directory records are read one block at a time */
+		cache = brasero_volume_source_open_cache (vol, BRASERO_VOL_SRC_CACHE_DEFAULT_BLOCKS);
+		brasero_volume_source_close (vol);
+		vol = cache;
+	}
+
+	/* Try the index of the whole session first; it's only created once */
+	index = NULL;
+	if (data->index)
+		index = brasero_data_session_index_get (data->index,
+							vol,
+							data->session_block);
+	if (index && brasero_io_image_directory_contents_from_index (data, index)) {
+		brasero_volume_source_close (vol);
+		brasero_device_handle_close (handle);
+		return BRASERO_ASYNC_TASK_FINISHED;
+	}
 
 	children = brasero_volume_load_directory_contents (vol,
 							   data->session_block,
@@ -148,29 +313,7 @@ brasero_io_image_directory_contents_thread (BraseroAsyncTaskManager *manager,
 	brasero_volume_source_close (vol);
 	brasero_device_handle_close (handle);
 
-	for (iter = children; iter; iter = iter->next) {
-		BraseroVolFile *file;
-		GFileInfo *info;
-
-		file = iter->data;
-
-		info = g_file_info_new ();
-		g_file_info_set_file_type (info, file->isdir? G_FILE_TYPE_DIRECTORY:G_FILE_TYPE_REGULAR);
-		g_file_info_set_name (info, BRASERO_VOLUME_FILE_NAME (file));
-
-		if (file->isdir)
-			g_file_info_set_attribute_int64 (info,
-							 BRASERO_IO_DIR_CONTENTS_ADDR,
-							 file->specific.dir.address);
-		else
-			g_file_info_set_size (info, BRASERO_VOLUME_FILE_SIZE (file));
-
-		brasero_io_return_result (data->job.base,
-					  data->job.uri,
-					  info,
-					  NULL,
-					  data->job.callback_data);
-	}
+	brasero_io_image_directory_contents_return (data, children);
 
 	g_list_foreach (children, (GFunc) brasero_volume_file_free, NULL);
 	g_list_free (children);
@@ -187,6 +330,7 @@ static void
 brasero_io_load_image_directory (const gchar *dev_image,
 				 gint64 session_block,
 				 gint64 block,
+				 BraseroDataSessionIndex *index,
 				 const BraseroIOJobBase *base,
 				 BraseroIOFlags options,
 				 gpointer user_data)
@@ -202,6 +346,8 @@ brasero_io_load_image_directory (const gchar *dev_image,
 	data = g_new0 (BraseroIOImageContentsData, 1);
 	data->block = block;
 	data->session_block = session_block;
+	if (index)
+		data->index = brasero_data_session_index_ref (index);
 
 	brasero_io_set_job (BRASERO_IO_JOB (data),
 			    base,
@@ -236,6 +382,11 @@ brasero_data_session_remove_last (BraseroDataSession *self)
 	g_slist_free (priv->nodes);
 	priv->nodes = NULL;
 
+	if (priv->index) {
+		brasero_data_session_index_unref (priv->index);
+		priv->index = NULL;
+	}
+
 	g_signal_emit (self,
 		       brasero_data_session_signals [LOADED_SIGNAL],
 		       0,
@@ -365,6 +516,7 @@ brasero_data_session_load_directory_contents_real (BraseroDataSession *self,
 	brasero_io_load_image_directory (device,
 					 session_block,
 					 BRASERO_FILE_NODE_IMPORTED_ADDRESS (node),
+					 priv->index,
 					 priv->load_dir,
 					 BRASERO_IO_INFO_URGENT,
 					 GINT_TO_POINTER (reference));
@@ -401,6 +553,10 @@ brasero_data_session_add_last (BraseroDataSession *self,
 	priv->loaded = medium;
 	g_object_ref (medium);
 
+	if (priv->index)
+		brasero_data_session_index_unref (priv->index);
+	priv->index = brasero_data_session_index_new ();
+
 	return brasero_data_session_load_directory_contents_real (self, NULL, error);
 }
 
@@ -607,6 +763,11 @@ brasero_data_session_finalize (GObject *object)
 		priv->nodes = NULL;
 	}
 
+	if (priv->index) {
+		brasero_data_session_index_unref (priv->index);
+		priv->index = NULL;
+	}
+
 	/* NOTE no need to clean up size_changed_sig since it's connected to 
 	 * ourselves. It disappears with use. */
 
@@ -66,6 +66,9 @@ struct _BraseroDataVFSPrivate
 
 	GSettings *settings;
 
+	/* Results delivered in a row are signalled as one batch */
+	guint batch_id;
+
 	guint replace_sym:1;
 	guint filter_hidden:1;
 	guint filter_broken_sym:1;
@@ -252,6 +255,34 @@ brasero_data_vfs_remove_from_hash (BraseroDataVFS *self,
 /**
  * Explore and add the contents of a directory already loaded
  */
+static gboolean
+brasero_data_vfs_batch_commit_cb (gpointer data)
+{
+	BraseroDataVFSPrivate *priv;
+
+	priv = BRASERO_DATA_VFS_PRIVATE (data);
+	priv->batch_id = 0;
+
+	brasero_data_project_commit_batch (BRASERO_DATA_PROJECT (data));
+	return FALSE;
+}
+
+static void
+brasero_data_vfs_batch (BraseroDataVFS *self)
+{
+	BraseroDataVFSPrivate *priv;
+
+	/* BraseroIO returns several results in a row. Open a batch that is
+	 * committed once they have all been processed so that size changes
+	 * and file changes are signalled only once. */
+	priv = BRASERO_DATA_VFS_PRIVATE (self);
+	if (priv->batch_id)
+		return;
+
+	brasero_data_project_begin_batch (BRASERO_DATA_PROJECT (self));
+	priv->batch_id = g_idle_add (brasero_data_vfs_batch_commit_cb, self);
+}
+
 static void
 brasero_data_vfs_directory_load_end (GObject *object,
 				     gboolean cancelled,
@@ -398,6 +429,8 @@ brasero_data_vfs_directory_load_result (GObject *owner,
 
 	priv = BRASERO_DATA_VFS_PRIVATE (self);
 
+	brasero_data_vfs_batch (self);
+
 	/* check the status of the operation.
 	 * NOTE: no need to remove the nodes. */
 	if (!brasero_data_vfs_check_uri_result (self, uri, error, info))
@@ -576,6 +609,8 @@ brasero_data_vfs_loading_node_result (GObject *owner,
 	BraseroDataVFS *self = BRASERO_DATA_VFS (owner);
 	BraseroDataVFSPrivate *priv = BRASERO_DATA_VFS_PRIVATE (self);
 
+	brasero_data_vfs_batch (self);
+
 	nodes = g_hash_table_lookup (priv->loading, registered);
 
 	/* check the status of the operation */
@@ -969,7 +1004,8 @@ brasero_data_vfs_empty_loading_cb (gpointer key,
 }
 
 static void
-brasero_data_vfs_clear (BraseroDataVFS *self)
+brasero_data_vfs_clear (BraseroDataVFS *self,
+			gboolean discard)
 {
 	BraseroDataVFSPrivate *priv;
 
@@ -997,6 +1033,17 @@ brasero_data_vfs_clear (BraseroDataVFS *self)
 				     self);
 
 	brasero_filtered_uri_clear (priv->filtered);
+
+	if (priv->batch_id) {
+		g_source_remove (priv->batch_id);
+		priv->batch_id = 0;
+
+		/* No signal should be emitted while finalizing */
+		if (discard)
+			brasero_data_project_discard_batch (BRASERO_DATA_PROJECT (self));
+		else
+			brasero_data_project_commit_batch (BRASERO_DATA_PROJECT (self));
+	}
 }
 
 static void
@@ -1017,7 +1064,7 @@ static void
 brasero_data_vfs_reset (BraseroDataProject *project,
 			guint num_nodes)
 {
-	brasero_data_vfs_clear (BRASERO_DATA_VFS (project));
+	brasero_data_vfs_clear (BRASERO_DATA_VFS (project), FALSE);
 
 	/* chain up this function except if we invalidated the node */
 	if (BRASERO_DATA_PROJECT_CLASS (brasero_data_vfs_parent_class)->reset)
@@ -1070,7 +1117,7 @@ brasero_data_vfs_finalize (GObject *object)
 {
 	BraseroDataVFSPrivate *priv;
 
-	brasero_data_vfs_clear (BRASERO_DATA_VFS (object));
+	brasero_data_vfs_clear (BRASERO_DATA_VFS (object), TRUE);
 
 	priv = BRASERO_DATA_VFS_PRIVATE (object);
 
@@ -41,15 +41,433 @@
 #include "burn-basics.h"
 
 #include "brasero-file-node.h"
+#include "brasero-image-layout.h"
 #include "brasero-io.h"
 
+/**
+ * Nodes are allocated from slabs to avoid the overhead of one allocation per
+ * node and to keep nodes close to each other in memory. A slab is freed as
+ * soon as all its nodes are freed so destroying a whole tree gives back the
+ * memory. Freed nodes are chained through their next pointer.
+ * NOTE: like the rest of the tree, this is only used from the main loop.
+ */
+
+#define BRASERO_FILE_NODE_SLAB_SIZE		512
+
+struct _BraseroFileNodeSlab {
+	BraseroFileNode nodes [BRASERO_FILE_NODE_SLAB_SIZE];
+
+	/* Freed nodes that can be reused */
+	BraseroFileNode *free;
+
+	/* Nodes that were never used are at the end */
+	guint used;
+	guint live;
+};
+typedef struct _BraseroFileNodeSlab BraseroFileNodeSlab;
+
+/* All slabs sorted by address */
+static GPtrArray *brasero_file_node_slabs = NULL;
+
+/* Slabs with room for at least one more node */
+static GSList *brasero_file_node_partial_slabs = NULL;
+
+static guint
+brasero_file_node_slab_find (BraseroFileNode *node)
+{
+	guint low = 0;
+	guint high;
+
+	/* Returns the position of the slab containing node (or the position
+	 * where a slab starting at node should be inserted) */
+	high = brasero_file_node_slabs->len;
+	while (low < high) {
+		BraseroFileNodeSlab *slab;
+		guint middle;
+
+		middle = (low + high) / 2;
+		slab = g_ptr_array_index (brasero_file_node_slabs, middle);
+		if (node < slab->nodes)
+			high = middle;
+		else if (node >= slab->nodes + BRASERO_FILE_NODE_SLAB_SIZE)
+			low = middle + 1;
+		else
+			return middle;
+	}
+
+	return low;
+}
+
+static BraseroFileNodeSlab *
+brasero_file_node_slab_new (void)
+{
+	BraseroFileNodeSlab *slab;
+	guint pos;
+
+	if (!brasero_file_node_slabs)
+		brasero_file_node_slabs = g_ptr_array_new ();
+
+	slab = g_new (BraseroFileNodeSlab, 1);
+	slab->free = NULL;
+	slab->used = 0;
+	slab->live = 0;
+
+	pos = brasero_file_node_slab_find (slab->nodes);
+	g_ptr_array_add (brasero_file_node_slabs, NULL);
+	memmove (brasero_file_node_slabs->pdata + pos + 1,
+		 brasero_file_node_slabs->pdata + pos,
+		 (brasero_file_node_slabs->len - pos - 1) * sizeof (gpointer));
+	brasero_file_node_slabs->pdata [pos] = slab;
+
+	brasero_file_node_partial_slabs = g_slist_prepend (brasero_file_node_partial_slabs, slab);
+	return slab;
+}
+
+static BraseroFileNode *
+brasero_file_node_alloc (void)
+{
+	BraseroFileNodeSlab *slab;
+	BraseroFileNode *node;
+
+	if (brasero_file_node_partial_slabs)
+		slab = brasero_file_node_partial_slabs->data;
+	else
+		slab = brasero_file_node_slab_new ();
+
+	if (slab->free) {
+		node = slab->free;
+		slab->free = node->next;
+	}
+	else
+		node = slab->nodes + slab->used ++;
+
+	slab->live ++;
+	if (!slab->free && slab->used == BRASERO_FILE_NODE_SLAB_SIZE)
+		brasero_file_node_partial_slabs = g_slist_remove (brasero_file_node_partial_slabs, slab);
+
+	memset (node, 0, sizeof (BraseroFileNode));
+	return node;
+}
+
+static void
+brasero_file_node_free (BraseroFileNode *node)
+{
+	BraseroFileNodeSlab *slab;
+	guint pos;
+
+	pos = brasero_file_node_slab_find (node);
+	slab = g_ptr_array_index (brasero_file_node_slabs, pos);
+
+	if (!slab->free && slab->used == BRASERO_FILE_NODE_SLAB_SIZE)
+		brasero_file_node_partial_slabs = g_slist_prepend (brasero_file_node_partial_slabs, slab);
+
+	slab->live --;
+	if (!slab->live) {
+		brasero_file_node_partial_slabs = g_slist_remove (brasero_file_node_partial_slabs, slab);
+		g_ptr_array_remove_index (brasero_file_node_slabs, pos);
+		g_free (slab);
+		return;
+	}
+
+	node->next = slab->free;
+	slab->free = node;
+}
+
+/**
+ * Children of a directory are a singly linked list. For directories with a
+ * lot of children that makes looking up a name, inserting a node in the
+ * sorted list or getting the nth child too slow (it is O(n) each time). So
+ * once a directory has more children than the following threshold, they are
+ * indexed by name and position. The index mirrors the list; it is kept
+ * up to date when a node is added or removed and dropped when the list is
+ * reordered (it is rebuilt the next time a lookup needs it).
+ */
+
+#define BRASERO_FILE_NODE_INDEX_THRESHOLD	128
+
+struct _BraseroFileNodeIndex {
+	/* All the children in the order of the list */
+	GPtrArray *children;
+
+	/* Name -> first child with this name (built when needed) */
+	GHashTable *names;
+	guint has_duplicates:1;
+
+	/* Child -> position + 1. Children are only numbered when looked up;
+	 * the numbers are right for the first positioned children, the
+	 * others moved since (an insertion or a removal shifts all the
+	 * children after it). */
+	GHashTable *positions;
+	guint positioned;
+};
+typedef struct _BraseroFileNodeIndex BraseroFileNodeIndex;
+
+/* Directory node -> BraseroFileNodeIndex */
+static GHashTable *brasero_file_node_indexes = NULL;
+
+static void
+brasero_file_node_index_destroy (gpointer data)
+{
+	BraseroFileNodeIndex *index = data;
+
+	if (index->names)
+		g_hash_table_destroy (index->names);
+
+	g_hash_table_destroy (index->positions);
+	g_ptr_array_free (index->children, TRUE);
+	g_free (index);
+}
+
+static BraseroFileNodeIndex *
+brasero_file_node_index_get (const BraseroFileNode *parent)
+{
+	if (!parent || !parent->has_index)
+		return NULL;
+
+	return g_hash_table_lookup (brasero_file_node_indexes, parent);
+}
+
+static BraseroFileNodeIndex *
+brasero_file_node_index_new (BraseroFileNode *parent)
+{
+	BraseroFileNodeIndex *index;
+	BraseroFileNode *iter;
+
+	if (!brasero_file_node_indexes)
+		brasero_file_node_indexes = g_hash_table_new_full (g_direct_hash,
+								   g_direct_equal,
+								   NULL,
+								   brasero_file_node_index_destroy);
+
+	index = g_new0 (BraseroFileNodeIndex, 1);
+	index->positions = g_hash_table_new (g_direct_hash, g_direct_equal);
+	index->children = g_ptr_array_sized_new (BRASERO_FILE_NODE_INDEX_THRESHOLD * 2);
+	for (iter = BRASERO_FILE_NODE_CHILDREN (parent); iter; iter = iter->next)
+		g_ptr_array_add (index->children, iter);
+
+	g_hash_table_insert (brasero_file_node_indexes, parent, index);
+	parent->has_index = TRUE;
+	return index;
+}
+
+static void
+brasero_file_node_index_free (BraseroFileNode *parent)
+{
+	if (!parent->has_index)
+		return;
+
+	g_hash_table_remove (brasero_file_node_indexes, parent);
+	parent->has_index = FALSE;
+}
+
+static void
+brasero_file_node_index_drop_names (BraseroFileNodeIndex *index)
+{
+	if (!index->names)
+		return;
+
+	g_hash_table_destroy (index->names);
+	index->names = NULL;
+	index->has_duplicates = FALSE;
+}
+
+static GHashTable *
+brasero_file_node_index_get_names (BraseroFileNodeIndex *index)
+{
+	guint i;
+
+	if (index->names)
+		return index->names;
+
+	/* NOTE: keys are the names of the nodes; they are not copied. So the
+	 * table must be dropped whenever a child is renamed. */
+	index->names = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < index->children->len; i ++) {
+		BraseroFileNode *node;
+		const gchar *name;
+
+		node = g_ptr_array_index (index->children, i);
+		name = BRASERO_FILE_NODE_NAME (node);
+
+		/* Keep the first one as a walk through the list would */
+		if (g_hash_table_lookup (index->names, name)) {
+			index->has_duplicates = TRUE;
+			continue;
+		}
+
+		g_hash_table_insert (index->names, (gpointer) name, node);
+	}
+
+	return index->names;
+}
+
+static gint
+brasero_file_node_index_find (BraseroFileNodeIndex *index,
+			      BraseroFileNode *node)
+{
+	guint pos;
+	guint i;
+
+	pos = GPOINTER_TO_UINT (g_hash_table_lookup (index->positions, node));
+	if (pos && pos - 1 < index->positioned)
+		return pos - 1;
+
+	/* Number the children that moved since the last lookup. That costs
+	 * no more than the memmove () of the insertions and removals that
+	 * moved them and consecutive lookups are then constant time. */
+	for (i = index->positioned; i < index->children->len; i ++)
+		g_hash_table_insert (index->positions,
+				     g_ptr_array_index (index->children, i),
+				     GUINT_TO_POINTER (i + 1));
+
+	index->positioned = index->children->len;
+
+	pos = GPOINTER_TO_UINT (g_hash_table_lookup (index->positions, node));
+	return (gint) pos - 1;
+}
+
+static void
+brasero_file_node_index_remove (BraseroFileNode *parent,
+				BraseroFileNodeIndex *index,
+				BraseroFileNode *node,
+				guint pos)
+{
+	/* unlink it from the list */
+	if (pos > 0) {
+		BraseroFileNode *previous;
+
+		previous = g_ptr_array_index (index->children, pos - 1);
+		previous->next = node->next;
+	}
+	else
+		parent->union2.children = node->next;
+
+	node->next = NULL;
+	g_ptr_array_remove_index (index->children, pos);
+
+	g_hash_table_remove (index->positions, node);
+	index->positioned = MIN (index->positioned, pos);
+
+	if (!index->names)
+		return;
+
+	/* Another node with the same name could have to replace it */
+	if (index->has_duplicates)
+		brasero_file_node_index_drop_names (index);
+	else if (g_hash_table_lookup (index->names, BRASERO_FILE_NODE_NAME (node)) == node)
+		g_hash_table_remove (index->names, BRASERO_FILE_NODE_NAME (node));
+}
+
+static guint
+brasero_file_node_index_insert (BraseroFileNode *parent,
+				BraseroFileNodeIndex *index,
+				BraseroFileNode *node,
+				GCompareFunc sort_func)
+{
+	GPtrArray *children;
+	guint pos;
+
+	children = index->children;
+
+	/* Set hidden nodes (whether virtual or not) always last */
+	if (node->is_hidden || !sort_func)
+		pos = children->len;
+	else {
+		guint low = 0;
+		guint high;
+
+		/* Look for the first node located after node, not counting
+		 * the hidden nodes at the end */
+		high = children->len;
+		while (high > 0 && ((BraseroFileNode *) g_ptr_array_index (children, high - 1))->is_hidden)
+			high --;
+
+		while (low < high) {
+			guint middle;
+
+			middle = (low + high) / 2;
+			if (sort_func (g_ptr_array_index (children, middle), node) > 0)
+				high = middle;
+			else
+				low = middle + 1;
+		}
+
+		pos = low;
+	}
+
+	/* link it in the list */
+	if (pos > 0) {
+		BraseroFileNode *previous;
+
+		previous = g_ptr_array_index (children, pos - 1);
+		node->next = previous->next;
+		previous->next = node;
+	}
+	else {
+		node->next = BRASERO_FILE_NODE_CHILDREN (parent);
+		parent->union2.children = node;
+	}
+
+	g_ptr_array_add (children, NULL);
+	memmove (children->pdata + pos + 1,
+		 children->pdata + pos,
+		 (children->len - pos - 1) * sizeof (gpointer));
+	children->pdata [pos] = node;
+
+	index->positioned = MIN (index->positioned, pos);
+
+	if (index->names) {
+		/* The new node could come before one with the same name */
+		if (g_hash_table_lookup (index->names, BRASERO_FILE_NODE_NAME (node)))
+			brasero_file_node_index_drop_names (index);
+		else
+			g_hash_table_insert (index->names,
+					     (gpointer) BRASERO_FILE_NODE_NAME (node),
+					     node);
+	}
+
+	return pos;
+}
+
+
+static void
+brasero_file_node_add_total_sectors (BraseroFileNode *parent,
+				     gint64 sectors)
+{
+	for (; parent; parent = parent->parent)
+		parent->total_sectors += sectors;
+}
+
+static void
+brasero_file_node_set_depth (BraseroFileNode *node,
+			     guint depth)
+{
+	BraseroFileNode *child;
+
+	depth = MIN (depth, BRASERO_FILE_NODE_DEPTH_MAX);
+	if (node->depth == depth)
+		return;
+
+	node->depth = depth;
+	if (node->is_file)
+		return;
+
+	/* NOTE: it's the same for the saved imported children */
+	for (child = BRASERO_FILE_NODE_CHILDREN (node); child; child = child->next)
+		brasero_file_node_set_depth (child, depth + 1);
+
+	if (node->has_import) {
+		for (child = BRASERO_FILE_NODE_IMPORT (node)->replaced; child; child = child->next)
+			brasero_file_node_set_depth (child, depth + 1);
+	}
+}
 
 BraseroFileNode *
 brasero_file_node_root_new (void)
 {
 	BraseroFileNode *root;
 
-	root = g_new0 (BraseroFileNode, 1);
+	root = brasero_file_node_alloc ();
 	root->is_root = TRUE;
 	root->is_imported = TRUE;
 
@@ -86,6 +504,10 @@ brasero_file_node_get_depth (BraseroFileNode *node)
 {
 	guint depth = 0;
 
+	if (node->depth < BRASERO_FILE_NODE_DEPTH_MAX
+	&& (node->parent || node->is_root))
+		return node->depth;
+
 	while (node) {
 		if (node->is_root)
 			return depth;
@@ -256,10 +678,41 @@ brasero_file_node_insert (BraseroFileNode *head,
 	return head;
 }
 
+static void
+brasero_file_node_insert_child (BraseroFileNode *parent,
+				BraseroFileNode *node,
+				GCompareFunc sort_func,
+				guint *newpos)
+{
+	BraseroFileNodeIndex *index;
+	guint pos = 0;
+
+	index = brasero_file_node_index_get (parent);
+	if (index) {
+		pos = brasero_file_node_index_insert (parent, index, node, sort_func);
+		if (newpos)
+			*newpos = pos;
+
+		return;
+	}
+
+	parent->union2.children = brasero_file_node_insert (BRASERO_FILE_NODE_CHILDREN (parent),
+							    node,
+							    sort_func,
+							    &pos);
+	if (newpos)
+		*newpos = pos;
+
+	/* There are at least as many children as the position of the node */
+	if (pos >= BRASERO_FILE_NODE_INDEX_THRESHOLD)
+		brasero_file_node_index_new (parent);
+}
+
 gint *
 brasero_file_node_need_resort (BraseroFileNode *node,
 			       GCompareFunc sort_func)
 {
+	BraseroFileNodeIndex *index;
 	BraseroFileNode *previous;
 	BraseroFileNode *parent;
 	BraseroFileNode *head;
@@ -273,9 +726,19 @@ brasero_file_node_need_resort (BraseroFileNode *node,
 
 	parent = node->parent;
 	head = BRASERO_FILE_NODE_CHILDREN (parent);
+	index = brasero_file_node_index_get (parent);
+
+	brasero_image_layout_node_changed (parent);
 
 	/* find previous node and get old position */
-	if (head != node) {
+	if (index) {
+		oldpos = brasero_file_node_index_find (index, node);
+		if (oldpos > 0)
+			previous = g_ptr_array_index (index->children, oldpos - 1);
+		else
+			previous = NULL;
+	}
+	else if (head != node) {
 		previous = head;
 		oldpos = 0;
 		while (previous->next != node) {
@@ -295,10 +758,16 @@ brasero_file_node_need_resort (BraseroFileNode *node,
 
 		/* move on the left */
 
-		previous->next = node->next;
+		if (index) {
+			brasero_file_node_index_remove (parent, index, node, oldpos);
+			newpos = brasero_file_node_index_insert (parent, index, node, sort_func);
+		}
+		else {
+			previous->next = node->next;
 
-		head = brasero_file_node_insert (head, node, sort_func, &newpos);
-		parent->union2.children = head;
+			head = brasero_file_node_insert (head, node, sort_func, &newpos);
+			parent->union2.children = head;
+		}
 
 		/* create an array to reflect the changes */
 		/* NOTE: hidden nodes are not taken into account. */
@@ -320,18 +789,24 @@ brasero_file_node_need_resort (BraseroFileNode *node,
 
 		/* move on the right */
 
-		if (previous)
-			previous->next = node->next;
-		else
-			parent->union2.children = node->next;
+		if (index) {
+			brasero_file_node_index_remove (parent, index, node, oldpos);
+			newpos = brasero_file_node_index_insert (parent, index, node, sort_func);
+		}
+		else {
+			if (previous)
+				previous->next = node->next;
+			else
+				parent->union2.children = node->next;
 
-		/* NOTE: here we're sure head hasn't changed since we checked 
-		 * that node should go after node->next (given as head for the
-		 * insertion here) */
-		brasero_file_node_insert (node->next, node, sort_func, &newpos);
+			/* NOTE: here we're sure head hasn't changed since we checked 
+			 * that node should go after node->next (given as head for the
+			 * insertion here) */
+			brasero_file_node_insert (node->next, node, sort_func, &newpos);
 
-		/* we started from oldpos so newpos needs updating */
-		newpos += oldpos;
+			/* we started from oldpos so newpos needs updating */
+			newpos += oldpos;
+		}
 
 		/* create an array to reflect the changes. */
 		/* NOTE: hidden nodes are not taken into account. */
@@ -401,6 +876,8 @@ brasero_file_node_sort_children (BraseroFileNode *parent,
 
 	/* set the new order */
 	parent->union2.children = new_order;
+	brasero_file_node_index_free (parent);
+	brasero_image_layout_node_changed (parent);
 
 	return array;
 }
@@ -480,6 +957,9 @@ brasero_file_node_reverse_children (BraseroFileNode *parent)
 
 end:
 
+	brasero_file_node_index_free (parent);
+	brasero_image_layout_node_changed (parent);
+
 	array = g_new (gint, size);
 
 	for (i = 0; i < firstfile; i ++)
@@ -495,16 +975,28 @@ BraseroFileNode *
 brasero_file_node_nth_child (BraseroFileNode *parent,
 			     guint nth)
 {
+	BraseroFileNodeIndex *index;
 	BraseroFileNode *peers;
 	guint pos;
 
 	if (!parent)
 		return NULL;
 
+	index = brasero_file_node_index_get (parent);
+	if (index) {
+		if (nth >= index->children->len)
+			return NULL;
+
+		return g_ptr_array_index (index->children, nth);
+	}
+
 	peers = BRASERO_FILE_NODE_CHILDREN (parent);
 	for (pos = 0; pos < nth && peers; pos ++)
 		peers = peers->next;
 
+	if (pos >= BRASERO_FILE_NODE_INDEX_THRESHOLD)
+		brasero_file_node_index_new (parent);
+
 	return peers;
 }
 
@@ -581,17 +1073,26 @@ BraseroFileNode *
 brasero_file_node_check_name_existence (BraseroFileNode *parent,
 				        const gchar *name)
 {
+	BraseroFileNodeIndex *index;
 	BraseroFileNode *iter;
+	guint num = 0;
 
 	if (name && name [0] == '\0')
 		return NULL;
 
+	index = brasero_file_node_index_get (parent);
+	if (index)
+		return g_hash_table_lookup (brasero_file_node_index_get_names (index), name);
+
 	iter = BRASERO_FILE_NODE_CHILDREN (parent);
-	for (; iter; iter = iter->next) {
+	for (; iter; iter = iter->next, num ++) {
 		if (!strcmp (name, BRASERO_FILE_NODE_NAME (iter)))
 			return iter;
 	}
 
+	if (num >= BRASERO_FILE_NODE_INDEX_THRESHOLD)
+		brasero_file_node_index_new (parent);
+
 	return NULL;
 }
 
@@ -599,28 +1100,32 @@ BraseroFileNode *
 brasero_file_node_get_from_path (BraseroFileNode *root,
 				 const gchar *path)
 {
-	gchar **array;
-	gchar **iter;
+	gchar *names;
+	gchar *name;
+	gchar *end;
 
 	if (!path)
 		return NULL;
 
-	/* If we don't do that array[0] == '\0' */
-	if (g_str_has_prefix (path, G_DIR_SEPARATOR_S))
-		array = g_strsplit (path + 1, G_DIR_SEPARATOR_S, 0);
-	else
-		array = g_strsplit (path, G_DIR_SEPARATOR_S, 0);
+	/* If we don't do that the first name would be '\0' */
+	if (path [0] == G_DIR_SEPARATOR)
+		path ++;
 
-	if (!array)
-		return NULL;
+	if (path [0] == '\0')
+		return root;
 
-	for (iter = array; iter && *iter; iter++) {
-		root = brasero_file_node_check_name_existence (root, *iter);
-		if (!root)
-			break;
+	/* Copy the path once and split it in place instead of allocating
+	 * every name of it */
+	names = g_strdup (path);
+	for (end = names; *end; end ++) {
+		if (*end == G_DIR_SEPARATOR)
+			*end = '\0';
 	}
-	g_strfreev (array);
 
+	for (name = names; root && name <= end; name += strlen (name) + 1)
+		root = brasero_file_node_check_name_existence (root, name);
+
+	g_free (names);
 	return root;
 }
 
@@ -747,11 +1252,51 @@ void
 brasero_file_node_rename (BraseroFileNode *node,
 			  const gchar *name)
 {
+	BraseroFileNodeIndex *index;
+
+	/* The name is used as a key in the index of the parent */
+	index = brasero_file_node_index_get (node->parent);
+	if (index)
+		brasero_file_node_index_drop_names (index);
+
 	g_free (BRASERO_FILE_NODE_NAME (node));
 	if (node->is_grafted)
 		node->union1.graft->name = g_strdup (name);
 	else
 		node->union1.name = g_strdup (name);
+
+	brasero_image_layout_node_changed (node->parent);
+}
+
+/**
+ * Turns a node created by the user into a node of the imported session (for
+ * directories address is the one of their records on the medium).
+ */
+
+void
+brasero_file_node_set_imported (BraseroFileNode *node,
+				guint address)
+{
+	guint64 old_total;
+
+	if (node->is_imported)
+		return;
+
+	old_total = BRASERO_FILE_NODE_TOTAL_SECTORS (node);
+
+	if (node->is_file)
+		node->is_fake = FALSE;
+	else
+		node->union3.imported_address = address;
+
+	node->is_imported = TRUE;
+
+	/* Imported files are not counted in the size of their ancestors */
+	if (node->parent) {
+		brasero_file_node_add_total_sectors (node->parent,
+						     (gint64) BRASERO_FILE_NODE_TOTAL_SECTORS (node) - (gint64) old_total);
+		brasero_image_layout_node_changed (node->parent);
+	}
 }
 
 void
@@ -762,15 +1307,17 @@ brasero_file_node_add (BraseroFileNode *parent,
 	BraseroFileTreeStats *stats;
 	guint depth = 0;
 
-	parent->union2.children = brasero_file_node_insert (BRASERO_FILE_NODE_CHILDREN (parent),
-							    node,
-							    sort_func,
-							    NULL);
+	brasero_file_node_insert_child (parent, node, sort_func, NULL);
 	node->parent = parent;
+	brasero_file_node_set_depth (node, parent->depth + 1);
 
 	if (BRASERO_FILE_NODE_VIRTUAL (node))
 		return;
 
+	brasero_image_layout_node_changed (parent);
+
+	brasero_file_node_add_total_sectors (parent, BRASERO_FILE_NODE_TOTAL_SECTORS (node));
+
 	stats = brasero_file_node_get_tree_stats (node->parent, &depth);
 	if (!node->is_imported) {
 		/* book keeping */
@@ -808,11 +1355,15 @@ brasero_file_node_set_from_info (BraseroFileNode *node,
 				 BraseroFileTreeStats *stats,
 				 GFileInfo *info)
 {
+	guint64 old_total;
+
 	/* NOTE: the name will never be replaced here since that means
 	 * we could replace a previously set name (that triggered the
 	 * creation of a graft). If someone wants to set a new name,
 	 * then rename_node is the function. */
 
+	old_total = BRASERO_FILE_NODE_TOTAL_SECTORS (node);
+
 	if (node->parent) {
 		/* update the stats since a file could have been added to the tree but
 		 * at this point we didn't know what it was (a file or a directory).
@@ -846,6 +1397,7 @@ brasero_file_node_set_from_info (BraseroFileNode *node,
 	node->is_symlink = (g_file_info_get_file_type (info) == G_FILE_TYPE_SYMBOLIC_LINK);
 
 	if (node->is_file) {
+		BraseroFileNode *parent;
 		guint sectors;
 		gint sectors_diff;
 
@@ -877,14 +1429,23 @@ brasero_file_node_set_from_info (BraseroFileNode *node,
 		 * the end and process all of entries at once, when it was
 		 * finished. We had to do that to calculate the whole size. */
 		sectors_diff = sectors - BRASERO_FILE_NODE_SECTORS (node);
-		for (; node; node = node->parent) {
-			node->union3.sectors += sectors_diff;
-			if (node->is_grafted)
+		for (parent = node; parent; parent = parent->parent) {
+			parent->union3.sectors += sectors_diff;
+			if (parent->is_grafted)
 				break;
 		}
 	}
 	else	/* since that's directory then it must be explored now */
 		node->is_exploring = TRUE;
+
+	/* The type, the size or the imported status may have changed */
+	if (node->parent) {
+		brasero_file_node_add_total_sectors (node->parent,
+						     (gint64) BRASERO_FILE_NODE_TOTAL_SECTORS (node) - (gint64) old_total);
+		brasero_image_layout_node_changed (node->parent);
+	}
+
+	brasero_image_layout_node_changed (node);
 }
 
 BraseroFileNode *
@@ -892,7 +1453,7 @@ brasero_file_node_new_loading (const gchar *name)
 {
 	BraseroFileNode *node;
 
-	node = g_new0 (BraseroFileNode, 1);
+	node = brasero_file_node_alloc ();
 	node->union1.name = g_strdup (name);
 	node->is_loading = TRUE;
 
@@ -908,7 +1469,7 @@ brasero_file_node_new_virtual (const gchar *name)
 	 * parents (and therefore replacable) and hidden (not displayed in the
 	 * GtkTreeModel). They are used as 'placeholders' to trigger
 	 * name-collision signal. */
-	node = g_new0 (BraseroFileNode, 1);
+	node = brasero_file_node_alloc ();
 	node->union1.name = g_strdup (name);
 	node->is_fake = TRUE;
 	node->is_hidden = TRUE;
@@ -921,7 +1482,7 @@ brasero_file_node_new (const gchar *name)
 {
 	BraseroFileNode *node;
 
-	node = g_new0 (BraseroFileNode, 1);
+	node = brasero_file_node_alloc ();
 	node->union1.name = g_strdup (name);
 
 	return node;
@@ -933,7 +1494,7 @@ brasero_file_node_new_imported_session_file (GFileInfo *info)
 	BraseroFileNode *node;
 
 	/* Create the node information */
-	node = g_new0 (BraseroFileNode, 1);
+	node = brasero_file_node_alloc ();
 	node->union1.name = g_strdup (g_file_info_get_name (info));
 	node->is_file = (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY);
 	node->is_imported = TRUE;
@@ -954,7 +1515,7 @@ brasero_file_node_new_empty_folder (const gchar *name)
 	BraseroFileNode *node;
 
 	/* Create the node information */
-	node = g_new0 (BraseroFileNode, 1);
+	node = brasero_file_node_alloc ();
 	node->union1.name = g_strdup (name);
 	node->is_fake = TRUE;
 
@@ -964,12 +1525,15 @@ brasero_file_node_new_empty_folder (const gchar *name)
 void
 brasero_file_node_unlink (BraseroFileNode *node)
 {
+	BraseroFileNodeIndex *index;
 	BraseroFileNode *iter;
 	BraseroImport *import;
 
 	if (!node->parent)
 		return;
 
+	brasero_image_layout_node_changed (node->parent);
+
 	iter = BRASERO_FILE_NODE_CHILDREN (node->parent);
 
 	/* handle the size change for previous parent */
@@ -986,21 +1550,36 @@ brasero_file_node_unlink (BraseroFileNode *node)
 		}
 	}
 
+	if (!BRASERO_FILE_NODE_VIRTUAL (node))
+		brasero_file_node_add_total_sectors (node->parent, - (gint64) BRASERO_FILE_NODE_TOTAL_SECTORS (node));
+
 	node->is_deep = FALSE;
 
-	if (iter == node) {
+	index = brasero_file_node_index_get (node->parent);
+	if (index) {
+		gint pos;
+
+		pos = brasero_file_node_index_find (index, node);
+		if (pos >= 0) {
+			brasero_file_node_index_remove (node->parent, index, node, pos);
+			node->parent = NULL;
+			return;
+		}
+	}
+	else if (iter == node) {
 		node->parent->union2.children = node->next;
 		node->parent = NULL;
 		node->next = NULL;
 		return;
 	}
-
-	for (; iter->next; iter = iter->next) {
-		if (iter->next == node) {
-			iter->next = node->next;
-			node->parent = NULL;
-			node->next = NULL;
-			return;
+	else {
+		for (; iter->next; iter = iter->next) {
+			if (iter->next == node) {
+				iter->next = node->next;
+				node->parent = NULL;
+				node->next = NULL;
+				return;
+			}
 		}
 	}
 
@@ -1057,11 +1636,14 @@ brasero_file_node_move_to (BraseroFileNode *node,
 		return;
 
 	/* reinsert it now at the new location */
-	parent->union2.children = brasero_file_node_insert (BRASERO_FILE_NODE_CHILDREN (parent),
-							    node,
-							    sort_func,
-							    NULL);
+	brasero_file_node_insert_child (parent, node, sort_func, NULL);
 	node->parent = parent;
+	brasero_file_node_set_depth (node, parent->depth + 1);
+
+	if (!BRASERO_FILE_NODE_VIRTUAL (node)) {
+		brasero_file_node_add_total_sectors (parent, BRASERO_FILE_NODE_TOTAL_SECTORS (node));
+		brasero_image_layout_node_changed (parent);
+	}
 
 	if (!node->is_grafted) {
 		BraseroFileNode *parent;
@@ -1097,6 +1679,9 @@ brasero_file_node_destroy_with_children (BraseroFileNode *node,
 	BraseroImport *import;
 	BraseroGraft *graft;
 
+	brasero_file_node_index_free (node);
+	brasero_image_layout_forget (node);
+
 	/* destroy all children recursively */
 	for (child = BRASERO_FILE_NODE_CHILDREN (node); child; child = next) {
 		next = child->next;
@@ -1151,7 +1736,7 @@ brasero_file_node_destroy_with_children (BraseroFileNode *node,
 		g_free (import->name);
 		g_free (import);
 	}
-	else
+	else if (BRASERO_FILE_NODE_NAME (node))
 		g_free (BRASERO_FILE_NODE_NAME (node));
 
 	/* destroy the node */
@@ -1161,7 +1746,7 @@ brasero_file_node_destroy_with_children (BraseroFileNode *node,
 	if (node->is_root)
 		g_free (BRASERO_FILE_NODE_STATS (node));
 
-	g_free (node);
+	brasero_file_node_free (node);
 }
 
 /**
@@ -1193,18 +1778,37 @@ brasero_file_node_save_imported_children (BraseroFileNode *node,
 					  BraseroFileTreeStats *stats,
 					  GCompareFunc sort_func)
 {
+	BraseroFileNode *previous = NULL;
 	BraseroFileNode *iter;
+	BraseroFileNode *next;
 	BraseroImport *import;
 
-	/* clean children */
-	for (iter = BRASERO_FILE_NODE_CHILDREN (node); iter; iter = iter->next) {
-		if (!iter->is_imported)
+	brasero_file_node_index_free (node);
+
+	/* clean children. NOTE: a destroyed node goes back to its slab (which
+	 * may be freed) so it must be unlinked first and never touched after */
+	for (iter = BRASERO_FILE_NODE_CHILDREN (node); iter; iter = next) {
+		next = iter->next;
+
+		if (!iter->is_imported) {
+			if (previous)
+				previous->next = next;
+			else
+				node->union2.children = next;
+
 			brasero_file_node_destroy_with_children (iter, stats);
+			continue;
+		}
 
+		previous = iter;
 		if (!iter->is_file)
 			brasero_file_node_save_imported_children (iter, stats, sort_func);
 	}
 
+	/* Only imported children are left and they don't count */
+	node->total_sectors = 0;
+	brasero_image_layout_node_changed (node);
+
 	/* restore all replaced children */
 	import = BRASERO_FILE_NODE_IMPORT (node);
 	if (!import)
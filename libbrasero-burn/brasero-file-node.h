@@ -122,6 +122,12 @@ struct _BraseroFileNode {
 		BraseroFileTreeStats *stats;
 	} union3;
 
+	/* For directories (root included): the sum of the sectors of all the
+	 * files in the subtree, whether they are grafted or not. Imported files
+	 * and virtual nodes are not counted. It is updated up the parent chain
+	 * whenever a node is added, removed, moved or changes size. */
+	guint total_sectors;
+
 	/* type of node */
 	guint is_root:1;
 	guint is_fake:1;
@@ -151,6 +157,10 @@ struct _BraseroFileNode {
 	/* Used to determine if is should be shown */
 	guint is_hidden:1;
 
+	/* Set for directories whose children are indexed (that is when they
+	 * have a lot of children) */
+	guint has_index:1;
+
 	/* Used by the model */
 	/* This is a workaround for a warning in gailtreeview.c line 2946 where
 	 * gail uses the GtkTreePath and not a copy which if the node inserted
@@ -162,8 +172,14 @@ struct _BraseroFileNode {
 
 	/* this is a ref count a max of 255 should be enough */
 	guint is_visible:7;
+
+	/* Depth in the tree (0 for root). Deeper nodes are at
+	 * BRASERO_FILE_NODE_DEPTH_MAX and their depth is computed. */
+	guint depth:7;
 };
 
+#define BRASERO_FILE_NODE_DEPTH_MAX		127
+
 /** Returns a const gchar* (it shouldn't be freed). */
 #define BRASERO_FILE_NODE_NAME(MACRO_node)					\
 	((MACRO_node)->is_grafted?(MACRO_node)->union1.graft->name:		\
@@ -185,6 +201,11 @@ struct _BraseroFileNode {
 #define BRASERO_FILE_NODE_SECTORS(MACRO_node)					\
 	((guint64) ((MACRO_node)->is_root?0:(MACRO_node)->union3.sectors))
 
+#define BRASERO_FILE_NODE_TOTAL_SECTORS(MACRO_node)				\
+	((guint64) ((MACRO_node)->is_file?						\
+		    ((MACRO_node)->is_imported?0:(MACRO_node)->union3.sectors):	\
+		    (MACRO_node)->total_sectors))
+
 #define BRASERO_FILE_NODE_STATS(MACRO_root)					\
 	((MACRO_root)->is_root?(MACRO_root)->union3.stats:NULL)
 
@@ -273,6 +294,9 @@ void
 brasero_file_node_set_from_info (BraseroFileNode *node,
 				 BraseroFileTreeStats *stats,
 				 GFileInfo *info);
+void
+brasero_file_node_set_imported (BraseroFileNode *node,
+				guint address);
 
 void
 brasero_file_node_graft (BraseroFileNode *file_node,
@@ -0,0 +1,407 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "brasero-units.h"
+
+#include "brasero-image-layout.h"
+
+/**
+ * The layout follows what libisofs (and mkisofs) write for the options we use:
+ * ISO9660 level 2 names with a version for files, Rock Ridge (RRIP 1.12) and
+ * optionally Joliet.
+ * - 16 sectors of system area, the primary volume descriptor, the Joliet
+ *   supplementary volume descriptor and the terminator
+ * - L and M path tables for ISO9660 and for Joliet
+ * - the directory records of every directory, each directory starting on a
+ *   new sector; a record never crosses a sector boundary
+ * - the continuation areas of the directories for the Rock Ridge entries that
+ *   don't fit in a record
+ * - a 150 sectors padding at the end
+ */
+
+#define BRASERO_IMAGE_LAYOUT_SECTOR		2048
+
+/* ECMA-119 9.1: 33 bytes + identifier (+ a padding byte if it is even) */
+#define BRASERO_IMAGE_LAYOUT_RECORD(MACRO_len)	(33 + (MACRO_len) + (((MACRO_len) & 1) ? 0:1))
+
+/* ECMA-119 9.4: 8 bytes + identifier (+ a padding byte if it is odd) */
+#define BRASERO_IMAGE_LAYOUT_PATH(MACRO_len)	(8 + (MACRO_len) + ((MACRO_len) & 1))
+
+#define BRASERO_IMAGE_LAYOUT_ISO_NAME_MAX	31
+#define BRASERO_IMAGE_LAYOUT_JOLIET_NAME_MAX	64
+
+/* Rock Ridge entries: PX (with inode number) and TF (modification, access
+ * and attribute change times) are in every record. NM holds at most 250
+ * bytes of the name. The length of a symlink target is not known so SL is
+ * given a reasonable size. */
+#define BRASERO_IMAGE_LAYOUT_RR_PX		44
+#define BRASERO_IMAGE_LAYOUT_RR_TF		26
+#define BRASERO_IMAGE_LAYOUT_RR_NM_HEADER	5
+#define BRASERO_IMAGE_LAYOUT_RR_NM_MAX		250
+#define BRASERO_IMAGE_LAYOUT_RR_SL		71
+#define BRASERO_IMAGE_LAYOUT_RR_CE		28
+#define BRASERO_IMAGE_LAYOUT_RR_SP		7
+#define BRASERO_IMAGE_LAYOUT_RR_ER		237
+
+/* Maximum size of a System Use area in a record */
+#define BRASERO_IMAGE_LAYOUT_RECORD_MAX		255
+
+/* Files over 4 GiB need one record per extent */
+#define BRASERO_IMAGE_LAYOUT_EXTENT_SECTORS	2097151
+
+#define BRASERO_IMAGE_LAYOUT_SYSTEM_AREA	16
+#define BRASERO_IMAGE_LAYOUT_PADDING		150
+
+struct _BraseroImageLayoutSizes {
+	/* In sectors: directory records and continuation areas */
+	gint64 iso;
+	gint64 joliet;
+
+	/* In bytes */
+	gint64 path_table;
+	gint64 joliet_path_table;
+};
+typedef struct _BraseroImageLayoutSizes BraseroImageLayoutSizes;
+
+struct _BraseroImageLayoutDir {
+	/* The directory itself and the path table entries of its children */
+	BraseroImageLayoutSizes own;
+
+	/* The directory and all its subdirectories */
+	BraseroImageLayoutSizes tree;
+
+	guint own_dirty:1;
+	guint tree_dirty:1;
+};
+typedef struct _BraseroImageLayoutDir BraseroImageLayoutDir;
+
+/* Directory node -> BraseroImageLayoutDir */
+static GHashTable *brasero_image_layout_dirs = NULL;
+
+static BraseroImageLayoutDir *
+brasero_image_layout_lookup (BraseroFileNode *node)
+{
+	if (!brasero_image_layout_dirs)
+		return NULL;
+
+	return g_hash_table_lookup (brasero_image_layout_dirs, node);
+}
+
+/**
+ * Called whenever the children of a directory (their number, their names,
+ * their sizes, their types or their order) changed.
+ */
+
+void
+brasero_image_layout_node_changed (BraseroFileNode *node)
+{
+	BraseroFileNode *parent;
+
+	for (parent = node; parent; parent = parent->parent) {
+		BraseroImageLayoutDir *dir;
+
+		dir = brasero_image_layout_lookup (parent);
+		if (!dir)
+			continue;
+
+		if (parent == node)
+			dir->own_dirty = TRUE;
+		else if (dir->tree_dirty) {
+			/* All the parents are already dirty */
+			break;
+		}
+
+		dir->tree_dirty = TRUE;
+	}
+}
+
+/**
+ * Called when a node is destroyed
+ */
+
+void
+brasero_image_layout_forget (BraseroFileNode *node)
+{
+	if (!brasero_image_layout_dirs)
+		return;
+
+	g_hash_table_remove (brasero_image_layout_dirs, node);
+}
+
+static guint
+brasero_image_layout_iso_name_len (BraseroFileNode *node)
+{
+	const gchar *name;
+	guint len;
+
+	/* Every character that is not a d-character is replaced by '_' */
+	name = BRASERO_FILE_NODE_NAME (node);
+	len = g_utf8_strlen (name, -1);
+
+	if (!node->is_file)
+		return MIN (len, BRASERO_IMAGE_LAYOUT_ISO_NAME_MAX);
+
+	/* Files always have a '.' and a version (";1") */
+	if (!strchr (name, '.'))
+		len ++;
+
+	return MIN (len, BRASERO_IMAGE_LAYOUT_ISO_NAME_MAX) + 2;
+}
+
+static guint
+brasero_image_layout_joliet_name_len (BraseroFileNode *node)
+{
+	const gchar *name;
+	guint len = 0;
+
+	/* Names are in UCS-2 (characters outside the BMP take 4 bytes) */
+	for (name = BRASERO_FILE_NODE_NAME (node); *name; name = g_utf8_next_char (name)) {
+		if (g_utf8_get_char (name) > 0xFFFF)
+			len += 2;
+		else
+			len ++;
+	}
+
+	len = MIN (len, BRASERO_IMAGE_LAYOUT_JOLIET_NAME_MAX) * 2;
+
+	/* Files have a version (";1") */
+	if (node->is_file)
+		len += 4;
+
+	return len;
+}
+
+static guint
+brasero_image_layout_rr_len (BraseroFileNode *node)
+{
+	guint name_len;
+	guint len;
+
+	len = BRASERO_IMAGE_LAYOUT_RR_PX + BRASERO_IMAGE_LAYOUT_RR_TF;
+
+	name_len = strlen (BRASERO_FILE_NODE_NAME (node));
+	len += name_len;
+	len += BRASERO_IMAGE_LAYOUT_RR_NM_HEADER *
+	       MAX (1, (name_len + BRASERO_IMAGE_LAYOUT_RR_NM_MAX - 1) / BRASERO_IMAGE_LAYOUT_RR_NM_MAX);
+
+	if (node->is_symlink)
+		len += BRASERO_IMAGE_LAYOUT_RR_SL;
+
+	return len + (len & 1);
+}
+
+static void
+brasero_image_layout_add_record (gint64 *sectors,
+				 guint *used,
+				 guint len)
+{
+	if (*used + len > BRASERO_IMAGE_LAYOUT_SECTOR) {
+		(*sectors) ++;
+		*used = 0;
+	}
+
+	*used += len;
+}
+
+static void
+brasero_image_layout_compute (BraseroFileNode *node,
+			      BraseroImageLayoutSizes *sizes)
+{
+	BraseroFileNode *child;
+	guint joliet_used = 0;
+	guint ce_bytes = 0;
+	guint used = 0;
+	guint dot_len;
+
+	memset (sizes, 0, sizeof (BraseroImageLayoutSizes));
+	sizes->iso = 1;
+	sizes->joliet = 1;
+
+	/* "." and ".." */
+	dot_len = BRASERO_IMAGE_LAYOUT_RECORD (1) +
+		  BRASERO_IMAGE_LAYOUT_RR_PX +
+		  BRASERO_IMAGE_LAYOUT_RR_TF;
+
+	if (node->is_root) {
+		/* The root "." has SP and the ER entry in a continuation area
+		 * (the record is padded to an even size) */
+		brasero_image_layout_add_record (&sizes->iso,
+						 &used,
+						 dot_len +
+						 BRASERO_IMAGE_LAYOUT_RR_SP +
+						 BRASERO_IMAGE_LAYOUT_RR_CE +
+						 1);
+		ce_bytes += BRASERO_IMAGE_LAYOUT_RR_ER;
+	}
+	else
+		brasero_image_layout_add_record (&sizes->iso, &used, dot_len);
+
+	brasero_image_layout_add_record (&sizes->iso, &used, dot_len);
+
+	brasero_image_layout_add_record (&sizes->joliet, &joliet_used, BRASERO_IMAGE_LAYOUT_RECORD (1));
+	brasero_image_layout_add_record (&sizes->joliet, &joliet_used, BRASERO_IMAGE_LAYOUT_RECORD (1));
+
+	for (child = BRASERO_FILE_NODE_CHILDREN (node); child; child = child->next) {
+		guint joliet_len;
+		guint extents = 1;
+		guint iso_len;
+		guint rr_len;
+		guint len;
+		guint i;
+
+		if (BRASERO_FILE_NODE_VIRTUAL (child))
+			continue;
+
+		iso_len = brasero_image_layout_iso_name_len (child);
+		joliet_len = brasero_image_layout_joliet_name_len (child);
+		rr_len = brasero_image_layout_rr_len (child);
+
+		len = BRASERO_IMAGE_LAYOUT_RECORD (iso_len);
+		if (len + rr_len > BRASERO_IMAGE_LAYOUT_RECORD_MAX) {
+			/* Only PX and TF stay in the record, the rest goes to
+			 * the continuation area */
+			len += BRASERO_IMAGE_LAYOUT_RR_PX +
+			       BRASERO_IMAGE_LAYOUT_RR_TF +
+			       BRASERO_IMAGE_LAYOUT_RR_CE;
+			ce_bytes += rr_len - BRASERO_IMAGE_LAYOUT_RR_PX - BRASERO_IMAGE_LAYOUT_RR_TF;
+		}
+		else
+			len += rr_len;
+
+		if (child->is_file && !child->is_imported && child->union3.sectors)
+			extents = (child->union3.sectors - 1) / BRASERO_IMAGE_LAYOUT_EXTENT_SECTORS + 1;
+
+		for (i = 0; i < extents; i ++) {
+			brasero_image_layout_add_record (&sizes->iso, &used, len);
+			brasero_image_layout_add_record (&sizes->joliet,
+							 &joliet_used,
+							 BRASERO_IMAGE_LAYOUT_RECORD (joliet_len));
+		}
+
+		if (!child->is_file) {
+			sizes->path_table += BRASERO_IMAGE_LAYOUT_PATH (iso_len);
+			sizes->joliet_path_table += BRASERO_IMAGE_LAYOUT_PATH (joliet_len);
+		}
+	}
+
+	sizes->iso += BRASERO_BYTES_TO_SECTORS (ce_bytes, BRASERO_IMAGE_LAYOUT_SECTOR);
+}
+
+static void
+brasero_image_layout_sizes_add (BraseroImageLayoutSizes *sizes,
+				BraseroImageLayoutSizes *added)
+{
+	sizes->iso += added->iso;
+	sizes->joliet += added->joliet;
+	sizes->path_table += added->path_table;
+	sizes->joliet_path_table += added->joliet_path_table;
+}
+
+static BraseroImageLayoutDir *
+brasero_image_layout_update (BraseroFileNode *node)
+{
+	BraseroImageLayoutDir *dir;
+	BraseroFileNode *child;
+
+	if (!brasero_image_layout_dirs)
+		brasero_image_layout_dirs = g_hash_table_new_full (g_direct_hash,
+								   g_direct_equal,
+								   NULL,
+								   g_free);
+
+	dir = g_hash_table_lookup (brasero_image_layout_dirs, node);
+	if (!dir) {
+		dir = g_new0 (BraseroImageLayoutDir, 1);
+		dir->own_dirty = TRUE;
+		dir->tree_dirty = TRUE;
+		g_hash_table_insert (brasero_image_layout_dirs, node, dir);
+	}
+
+	if (!dir->tree_dirty)
+		return dir;
+
+	if (dir->own_dirty) {
+		brasero_image_layout_compute (node, &dir->own);
+		dir->own_dirty = FALSE;
+	}
+
+	/* NOTE: only the directories whose contents changed are walked */
+	dir->tree = dir->own;
+	for (child = BRASERO_FILE_NODE_CHILDREN (node); child; child = child->next) {
+		BraseroImageLayoutDir *child_dir;
+
+		if (child->is_file || BRASERO_FILE_NODE_VIRTUAL (child))
+			continue;
+
+		child_dir = brasero_image_layout_update (child);
+		brasero_image_layout_sizes_add (&dir->tree, &child_dir->tree);
+	}
+
+	dir->tree_dirty = FALSE;
+	return dir;
+}
+
+goffset
+brasero_image_layout_get_sectors (BraseroFileNode *root,
+				  BraseroImageFS fs_type)
+{
+	BraseroImageLayoutDir *dir;
+	goffset path_table;
+	goffset sectors;
+
+	dir = brasero_image_layout_update (root);
+
+	/* volume descriptors */
+	sectors = BRASERO_IMAGE_LAYOUT_SYSTEM_AREA + 2;
+
+	/* The root has an entry in the path tables as well */
+	path_table = dir->tree.path_table + BRASERO_IMAGE_LAYOUT_PATH (1);
+	sectors += BRASERO_BYTES_TO_SECTORS (path_table, BRASERO_IMAGE_LAYOUT_SECTOR) * 2;
+	sectors += dir->tree.iso;
+
+	if (fs_type & BRASERO_IMAGE_FS_JOLIET) {
+		sectors ++;
+
+		path_table = dir->tree.joliet_path_table + BRASERO_IMAGE_LAYOUT_PATH (1);
+		sectors += BRASERO_BYTES_TO_SECTORS (path_table, BRASERO_IMAGE_LAYOUT_SECTOR) * 2;
+		sectors += dir->tree.joliet;
+	}
+
+	sectors += BRASERO_IMAGE_LAYOUT_PADDING;
+	return sectors;
+}
@@ -48,6 +48,15 @@ G_BEGIN_DECLS
 
 #define BRASERO_TRACK_MEDIUM_WRONG_CHECKSUM_TAG		"track::medium::error::checksum::list"
 
+/**
+ * Strings holding the digests of an image or a medium track. They are all
+ * computed during the same read pass whatever the checksum type of the track.
+ */
+
+#define BRASERO_TRACK_CHECKSUM_MD5_TAG			"track::checksum::md5"
+#define BRASERO_TRACK_CHECKSUM_SHA1_TAG			"track::checksum::sha1"
+#define BRASERO_TRACK_CHECKSUM_SHA256_TAG		"track::checksum::sha256"
+
 /**
  * Strings
  */
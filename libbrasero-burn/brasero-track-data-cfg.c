@@ -53,6 +53,10 @@
 #include "burn-basics.h"
 #include "brasero-data-project.h"
 #include "brasero-data-tree-model.h"
+#include "brasero-image-layout.h"
+
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_PROPS_SPAN_SPLIT_DEPTH	"span-split-depth"
 
 typedef struct _BraseroTrackDataCfgPrivate BraseroTrackDataCfgPrivate;
 struct _BraseroTrackDataCfgPrivate
@@ -79,6 +83,9 @@ struct _BraseroTrackDataCfgPrivate
 
 	GSList *shown;
 
+	/* Directory node -> BraseroTrackDataCfgRows */
+	GHashTable *rows;
+
 	gint sort_column;
 	GtkSortType sort_type;
 
@@ -141,17 +148,194 @@ static gulong brasero_track_data_cfg_signals [LAST_SIGNAL] = { 0 };
  * GtkTreeModel part
  */
 
+/**
+ * Visible rows of the directories (that is, their children that are not
+ * hidden) are cached so that getting the nth row or the position of a node
+ * doesn't need to walk the list of children each time. They are kept in a
+ * GSequence so that adding or removing a row, getting the nth row and the
+ * position of a node are all O(log n); each added or removed node updates the
+ * rows of its parent in place. The rows of a directory are only dropped when
+ * its children are reordered or when it is removed.
+ */
+
+struct _BraseroTrackDataCfgRows {
+	GSequence *nodes;
+
+	/* Node -> GSequenceIter */
+	GHashTable *iters;
+};
+typedef struct _BraseroTrackDataCfgRows BraseroTrackDataCfgRows;
+
+static void
+brasero_track_data_cfg_rows_free (gpointer data)
+{
+	BraseroTrackDataCfgRows *rows = data;
+
+	g_hash_table_destroy (rows->iters);
+	g_sequence_free (rows->nodes);
+	g_free (rows);
+}
+
+static BraseroTrackDataCfgRows *
+brasero_track_data_cfg_get_rows (BraseroTrackDataCfg *self,
+				 const BraseroFileNode *parent)
+{
+	BraseroTrackDataCfgPrivate *priv;
+	BraseroTrackDataCfgRows *rows;
+	BraseroFileNode *child;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+
+	rows = g_hash_table_lookup (priv->rows, parent);
+	if (rows)
+		return rows;
+
+	rows = g_new0 (BraseroTrackDataCfgRows, 1);
+	rows->nodes = g_sequence_new (NULL);
+	rows->iters = g_hash_table_new (g_direct_hash, g_direct_equal);
+	for (child = BRASERO_FILE_NODE_CHILDREN (parent); child; child = child->next) {
+		/* Don't count hidden nodes */
+		if (child->is_hidden)
+			continue;
+
+		g_hash_table_insert (rows->iters,
+				     child,
+				     g_sequence_append (rows->nodes, child));
+	}
+
+	g_hash_table_insert (priv->rows, (gpointer) parent, rows);
+	return rows;
+}
+
+static void
+brasero_track_data_cfg_rows_changed (BraseroTrackDataCfg *self,
+				     BraseroFileNode *parent)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+	if (parent)
+		g_hash_table_remove (priv->rows, parent);
+	else
+		g_hash_table_remove_all (priv->rows);
+}
+
+static void
+brasero_track_data_cfg_rows_remove (BraseroTrackDataCfgRows *rows,
+				    BraseroFileNode *node)
+{
+	GSequenceIter *iter;
+
+	iter = g_hash_table_lookup (rows->iters, node);
+	if (!iter)
+		return;
+
+	g_hash_table_remove (rows->iters, node);
+	g_sequence_remove (iter);
+}
+
+static void
+brasero_track_data_cfg_rows_node_added (BraseroTrackDataCfg *self,
+					BraseroFileNode *node)
+{
+	BraseroTrackDataCfgPrivate *priv;
+	BraseroTrackDataCfgRows *rows;
+	BraseroFileNode *next;
+	GSequenceIter *iter;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+
+	rows = g_hash_table_lookup (priv->rows, node->parent);
+	if (!rows)
+		return;
+
+	/* A node that is reloaded may have moved */
+	brasero_track_data_cfg_rows_remove (rows, node);
+	if (node->is_hidden)
+		return;
+
+	/* Insert the node before the next visible peer (hidden nodes are
+	 * always last so that's usually the next one) */
+	next = node->next;
+	while (next && next->is_hidden)
+		next = next->next;
+
+	if (!next) {
+		iter = g_sequence_append (rows->nodes, node);
+		g_hash_table_insert (rows->iters, node, iter);
+		return;
+	}
+
+	iter = g_hash_table_lookup (rows->iters, next);
+	if (!iter) {
+		/* That should not happen; start again from the list */
+		brasero_track_data_cfg_rows_changed (self, node->parent);
+		return;
+	}
+
+	iter = g_sequence_insert_before (iter, node);
+	g_hash_table_insert (rows->iters, node, iter);
+}
+
+static void
+brasero_track_data_cfg_rows_forget (BraseroTrackDataCfg *self,
+				    BraseroFileNode *node)
+{
+	BraseroTrackDataCfgPrivate *priv;
+	BraseroFileNode *child;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+
+	/* NOTE: rows can be cached for a directory and not for its parent so
+	 * walk the whole subtree; it is about to be destroyed anyway which
+	 * costs as much. */
+	g_hash_table_remove (priv->rows, node);
+	for (child = BRASERO_FILE_NODE_CHILDREN (node); child; child = child->next) {
+		if (!child->is_file)
+			brasero_track_data_cfg_rows_forget (self, child);
+	}
+}
+
+static void
+brasero_track_data_cfg_rows_node_removed (BraseroTrackDataCfg *self,
+					  BraseroFileNode *former_parent,
+					  BraseroFileNode *node)
+{
+	BraseroTrackDataCfgPrivate *priv;
+	BraseroTrackDataCfgRows *rows;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+
+	rows = g_hash_table_lookup (priv->rows, former_parent);
+	if (rows)
+		brasero_track_data_cfg_rows_remove (rows, node);
+
+	/* The node and all its children are going to be destroyed */
+	if (!node->is_file)
+		brasero_track_data_cfg_rows_forget (self, node);
+}
+
 static guint
-brasero_track_data_cfg_get_pos_as_child (BraseroFileNode *node)
+brasero_track_data_cfg_get_pos_as_child (BraseroTrackDataCfg *self,
+					 BraseroFileNode *node)
 {
+	BraseroTrackDataCfgRows *rows;
 	BraseroFileNode *parent;
 	BraseroFileNode *peers;
+	GSequenceIter *iter;
 	guint pos = 0;
 
 	if (!node)
 		return 0;
 
 	parent = node->parent;
+	rows = brasero_track_data_cfg_get_rows (self, parent);
+	iter = g_hash_table_lookup (rows->iters, node);
+	if (iter)
+		return g_sequence_iter_get_position (iter);
+
+	/* The node is hidden */
+	pos = 0;
 	for (peers = BRASERO_FILE_NODE_CHILDREN (parent); peers; peers = peers->next) {
 		if (peers == node)
 			break;
@@ -176,7 +360,7 @@ brasero_track_data_cfg_node_to_path (BraseroTrackDataCfg *self,
 	for (; node->parent && !node->is_root; node = node->parent) {
 		guint nth;
 
-		nth = brasero_track_data_cfg_get_pos_as_child (node);
+		nth = brasero_track_data_cfg_get_pos_as_child (self, node);
 		gtk_tree_path_prepend_index (path, nth);
 	}
 
@@ -219,28 +403,20 @@ brasero_track_data_cfg_iter_parent (GtkTreeModel *model,
 }
 
 static BraseroFileNode *
-brasero_track_data_cfg_nth_child (BraseroFileNode *parent,
+brasero_track_data_cfg_nth_child (BraseroTrackDataCfg *self,
+				  BraseroFileNode *parent,
 				  guint nth)
 {
-	BraseroFileNode *peers;
-	gint pos;
+	BraseroTrackDataCfgRows *rows;
 
 	if (!parent)
 		return NULL;
 
-	peers = BRASERO_FILE_NODE_CHILDREN (parent);
-	while (peers && peers->is_hidden)
-		peers = peers->next;
-		
-	for (pos = 0; pos < nth && peers; pos ++) {
-		peers = peers->next;
-
-		/* Skip hidden */
-		while (peers && peers->is_hidden)
-			peers = peers->next;
-	}
+	rows = brasero_track_data_cfg_get_rows (self, parent);
+	if (nth >= g_sequence_get_length (rows->nodes))
+		return NULL;
 
-	return peers;
+	return g_sequence_get (g_sequence_get_iter_at_pos (rows->nodes, nth));
 }
 
 static gboolean
@@ -270,7 +446,7 @@ brasero_track_data_cfg_iter_nth_child (GtkTreeModel *model,
 	else
 		node = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
 
-	iter->user_data = brasero_track_data_cfg_nth_child (node, n);
+	iter->user_data = brasero_track_data_cfg_nth_child (BRASERO_TRACK_DATA_CFG (model), node, n);
 	if (!iter->user_data)
 		return FALSE;
 
@@ -280,22 +456,16 @@ brasero_track_data_cfg_iter_nth_child (GtkTreeModel *model,
 }
 
 static guint
-brasero_track_data_cfg_get_n_children (const BraseroFileNode *node)
+brasero_track_data_cfg_get_n_children (BraseroTrackDataCfg *self,
+				       const BraseroFileNode *node)
 {
-	BraseroFileNode *children;
-	guint num = 0;
+	BraseroTrackDataCfgRows *rows;
 
 	if (!node)
 		return 0;
 
-	for (children = BRASERO_FILE_NODE_CHILDREN (node); children; children = children->next) {
-		if (children->is_hidden)
-			continue;
-
-		num ++;
-	}
-
-	return num;
+	rows = brasero_track_data_cfg_get_rows (self, node);
+	return g_sequence_get_length (rows->nodes);
 }
 
 static gint
@@ -310,7 +480,7 @@ brasero_track_data_cfg_iter_n_children (GtkTreeModel *model,
 	if (iter == NULL) {
 		/* special case */
 		node = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
-		return brasero_track_data_cfg_get_n_children (node);
+		return brasero_track_data_cfg_get_n_children (BRASERO_TRACK_DATA_CFG (model), node);
 	}
 
 	/* make sure that iter comes from us */
@@ -325,10 +495,10 @@ brasero_track_data_cfg_iter_n_children (GtkTreeModel *model,
 		return 0;
 
 	/* return at least one for the bogus row labelled "empty". */
-	if (!brasero_track_data_cfg_get_n_children (node))
+	if (!brasero_track_data_cfg_get_n_children (BRASERO_TRACK_DATA_CFG (model), node))
 		return 1;
 
-	return brasero_track_data_cfg_get_n_children (node);
+	return brasero_track_data_cfg_get_n_children (BRASERO_TRACK_DATA_CFG (model), node);
 }
 
 static gboolean
@@ -419,7 +589,7 @@ brasero_track_data_cfg_iter_children (GtkTreeModel *model,
 	}
 
 	iter->stamp = priv->stamp;
-	if (!brasero_track_data_cfg_get_n_children (node)) {
+	if (!brasero_track_data_cfg_get_n_children (BRASERO_TRACK_DATA_CFG (model), node)) {
 		/* This is a directory but it hasn't got any child; yet
 		 * we show a row written empty for that. Set bogus in
 		 * user_data and put parent in user_data. */
@@ -428,7 +598,8 @@ brasero_track_data_cfg_iter_children (GtkTreeModel *model,
 		return TRUE;
 	}
 
-	iter->user_data = BRASERO_FILE_NODE_CHILDREN (node);
+	/* The first visible child */
+	iter->user_data = brasero_track_data_cfg_nth_child (BRASERO_TRACK_DATA_CFG (model), node, 0);
 	iter->user_data2 = GINT_TO_POINTER (BRASERO_ROW_REGULAR);
 	return TRUE;
 }
@@ -794,7 +965,7 @@ brasero_track_data_cfg_get_value (GtkTreeModel *model,
 				return;
 			}
 
-			nb_items = brasero_track_data_cfg_get_n_children (node);
+			nb_items = brasero_track_data_cfg_get_n_children (BRASERO_TRACK_DATA_CFG (model), node);
 			if (!nb_items)
 				g_value_set_string (value, _("Empty"));
 			else {
@@ -939,7 +1110,7 @@ brasero_track_data_cfg_path_to_node (BraseroTrackDataCfg *self,
 		BraseroFileNode *parent;
 
 		parent = node;
-		node = brasero_track_data_cfg_nth_child (parent, indices [i]);
+		node = brasero_track_data_cfg_nth_child (self, parent, indices [i]);
 		if (!node)
 			return NULL;
 	}
@@ -968,7 +1139,7 @@ brasero_track_data_cfg_get_iter (GtkTreeModel *model,
 	if (!root)
 		return FALSE;
 		
-	node = brasero_track_data_cfg_nth_child (root, indices [0]);
+	node = brasero_track_data_cfg_nth_child (BRASERO_TRACK_DATA_CFG (model), root, indices [0]);
 	if (!node)
 		return FALSE;
 
@@ -976,13 +1147,13 @@ brasero_track_data_cfg_get_iter (GtkTreeModel *model,
 		BraseroFileNode *parent;
 
 		parent = node;
-		node = brasero_track_data_cfg_nth_child (parent, indices [i]);
+		node = brasero_track_data_cfg_nth_child (BRASERO_TRACK_DATA_CFG (model), parent, indices [i]);
 		if (!node) {
 			/* There is one case where this can happen and
 			 * is allowed: that's when the parent is an
 			 * empty directory. Then index must be 0. */
 			if (!parent->is_file
-			&&  !brasero_track_data_cfg_get_n_children (parent)
+			&&  !brasero_track_data_cfg_get_n_children (BRASERO_TRACK_DATA_CFG (model), parent)
 			&&   indices [i] == 0) {
 				iter->stamp = priv->stamp;
 				iter->user_data = parent;
@@ -1439,6 +1610,12 @@ brasero_track_data_cfg_node_added (BraseroDataProject *project,
 
 	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
 
+	/* Add the row to the parent. If that's a directory that was moved its
+	 * own rows may be outdated too. */
+	brasero_track_data_cfg_rows_node_added (self, node);
+	if (!node->is_file)
+		brasero_track_data_cfg_rows_changed (self, node);
+
 	if (priv->icon == node) {
 		/* Our icon node has showed up, signal that */
 		g_signal_emit (self,
@@ -1509,7 +1686,7 @@ brasero_track_data_cfg_node_added (BraseroDataProject *project,
 		/* Check if the parent of this node is empty if so remove the BOGUS row.
 		 * Do it afterwards to prevent the parent row to be collapsed if it was
 		 * previously expanded. */
-		if (parent && brasero_track_data_cfg_get_n_children (parent) == 1) {
+		if (parent && brasero_track_data_cfg_get_n_children (self, parent) == 1) {
 			gtk_tree_path_append_index (path, 1);
 			gtk_tree_model_row_deleted (GTK_TREE_MODEL (self), path);
 		}
@@ -1568,6 +1745,9 @@ brasero_track_data_cfg_node_removed (BraseroDataProject *project,
 	GtkTreePath *path;
 
 	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+
+	brasero_track_data_cfg_rows_node_removed (self, former_parent, node);
+
 	/* NOTE: there is no special case of autorun.inf here when we created
 	 * it as a temprary file since it's hidden and BraseroDataTreeModel
 	 * won't emit a signal for removed file in this case.
@@ -1607,7 +1787,7 @@ brasero_track_data_cfg_node_removed (BraseroDataProject *project,
 	 * add a bogus row. If it hasn't got children then it only remains our
 	 * node in the list.
 	 * NOTE: parent has to be a directory. */
-	if (!former_parent->is_root && !brasero_track_data_cfg_get_n_children (former_parent)) {
+	if (!former_parent->is_root && !brasero_track_data_cfg_get_n_children (self, former_parent)) {
 		GtkTreeIter iter;
 
 		iter.stamp = priv->stamp;
@@ -1641,6 +1821,9 @@ brasero_track_data_cfg_node_changed (BraseroDataProject *project,
 
 	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
 
+	if (!node->is_file)
+		brasero_track_data_cfg_rows_changed (self, node);
+
 	/* Get the iter for the node */
 	iter.stamp = priv->stamp;
 	iter.user_data = node;
@@ -1673,7 +1856,7 @@ brasero_track_data_cfg_node_changed (BraseroDataProject *project,
 								      NULL);
 
 		/* add the row */
-		if (!brasero_track_data_cfg_get_n_children (node))  {
+		if (!brasero_track_data_cfg_get_n_children (self, node))  {
 			iter.user_data2 = GINT_TO_POINTER (BRASERO_ROW_BOGUS);
 			gtk_tree_path_append_index (path, 0);
 
@@ -1696,6 +1879,8 @@ brasero_track_data_cfg_node_reordered (BraseroDataProject *project,
 
 	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
 
+	brasero_track_data_cfg_rows_changed (self, parent);
+
 	treepath = brasero_track_data_cfg_node_to_path (self, parent);
 	if (parent != brasero_data_project_get_root (project)) {
 		GtkTreeIter iter;
@@ -2023,9 +2208,10 @@ brasero_track_data_cfg_reset (BraseroTrackDataCfg *track)
 	brasero_track_data_clean_autorun (track);
 
 	root = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
-	num = brasero_track_data_cfg_get_n_children (root);
+	num = brasero_track_data_cfg_get_n_children (track, root);
 
 	brasero_data_project_reset (BRASERO_DATA_PROJECT (priv->tree));
+	brasero_track_data_cfg_rows_changed (track, NULL);
 
 	treepath = gtk_tree_path_new_first ();
 	for (i = 0; i < num; i++)
@@ -2450,17 +2636,15 @@ brasero_track_data_cfg_get_size (BraseroTrack *track,
 	if (blocks) {
 		BraseroFileNode *root;
 		BraseroImageFS fs_type;
-		BraseroFileTreeStats *stats;
 
 		if (!sectors)
 			return sectors;
 
+		/* Add the size of the file system structures as they will be
+		 * laid out in the image. */
 		fs_type = brasero_track_data_cfg_get_fs (BRASERO_TRACK_DATA (track));
 		root = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
-		stats = BRASERO_FILE_NODE_STATS (root);
-		sectors = brasero_data_project_improve_image_size_accuracy (sectors,
-									    stats->num_dir,
-									    fs_type);
+		sectors += brasero_image_layout_get_sectors (root, fs_type);
 		*blocks = sectors;
 	}
 
@@ -3005,6 +3189,40 @@ brasero_track_data_cfg_span_possible (BraseroTrackDataCfg *track,
 						   sectors);
 }
 
+/**
+ * brasero_track_data_cfg_span_get_plan:
+ * @track: a #BraseroTrackDataCfg
+ * @sectors: a #goffset
+ * @fill_ratios: a #GArray or NULL
+ *
+ * Plans how the files remaining in the tree after calls to brasero_track_data_cfg_span ()
+ * would be spread across discs of @sectors. If @fill_ratios is not NULL, it is set to a
+ * new #GArray of #gdouble holding the fill ratio (between 0 and 1) of each disc in the
+ * order they would be burnt. Free it with g_array_free ().
+ *
+ * Return value: a #BraseroBurnResult. BRASERO_BURN_OK if there is not anymore data.
+ * BRASERO_BURN_RETRY if at least one disc is needed.
+ * BRASERO_BURN_ERR otherwise.
+ **/
+
+BraseroBurnResult
+brasero_track_data_cfg_span_get_plan (BraseroTrackDataCfg *track,
+				      goffset sectors,
+				      GArray **fill_ratios)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+	if (priv->loading
+	||  brasero_data_vfs_is_active (BRASERO_DATA_VFS (priv->tree))
+	||  brasero_data_session_get_loaded_medium (BRASERO_DATA_SESSION (priv->tree)) != NULL)
+		return BRASERO_BURN_NOT_READY;
+
+	return brasero_data_project_span_get_plan (BRASERO_DATA_PROJECT (priv->tree),
+						   sectors,
+						   fill_ratios);
+}
+
 /**
  * brasero_track_data_cfg_span_stop:
  * @track: a #BraseroTrackDataCfg
@@ -3289,6 +3507,8 @@ static void
 brasero_track_data_cfg_init (BraseroTrackDataCfg *object)
 {
 	BraseroTrackDataCfgPrivate *priv;
+	GSettings *settings;
+	gint depth;
 
 	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (object);
 
@@ -3298,8 +3518,18 @@ brasero_track_data_cfg_init (BraseroTrackDataCfg *object)
 	} while (!priv->stamp);
 
 	priv->theme = gtk_icon_theme_get_default ();
+	priv->rows = g_hash_table_new_full (g_direct_hash,
+					    g_direct_equal,
+					    NULL,
+					    brasero_track_data_cfg_rows_free);
 	priv->tree = brasero_data_tree_model_new ();
 
+	/* How deep directories too big for a disc can be split when spanning */
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	depth = g_settings_get_int (settings, BRASERO_PROPS_SPAN_SPLIT_DEPTH);
+	brasero_data_project_set_span_split_depth (BRASERO_DATA_PROJECT (priv->tree), MAX (depth, 0));
+	g_object_unref (settings);
+
 	g_signal_connect (priv->tree,
 			  "row-added",
 			  G_CALLBACK (brasero_track_data_cfg_node_added),
@@ -3392,6 +3622,11 @@ brasero_track_data_cfg_finalize (GObject *object)
 		priv->shown = NULL;
 	}
 
+	if (priv->rows) {
+		g_hash_table_destroy (priv->rows);
+		priv->rows = NULL;
+	}
+
 	if (priv->tree) {
 		/* This object could outlive us just for some time
 		 * so we better remove all signals.
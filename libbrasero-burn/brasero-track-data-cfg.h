@@ -164,6 +164,11 @@ BraseroBurnResult
 brasero_track_data_cfg_span_possible (BraseroTrackDataCfg *track,
 				      goffset sectors);
 
+BraseroBurnResult
+brasero_track_data_cfg_span_get_plan (BraseroTrackDataCfg *track,
+				      goffset sectors,
+				      GArray **fill_ratios);
+
 goffset
 brasero_track_data_cfg_span_max_space (BraseroTrackDataCfg *track);
 
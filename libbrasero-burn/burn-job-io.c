@@ -0,0 +1,206 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+/* This is for tee () and F_SETPIPE_SZ */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gi18n-lib.h>
+
+#include "burn-basics.h"
+#include "burn-debug.h"
+#include "burn-job-io.h"
+
+/* How long to wait (in ms) for a file descriptor to be ready before giving the
+ * hand back to the caller so that it can check for cancellation */
+#define BRASERO_JOB_IO_TIMEOUT		500
+
+static gboolean
+brasero_job_io_wait (int fd,
+		     short events)
+{
+	struct pollfd poll_fd;
+
+	poll_fd.fd = fd;
+	poll_fd.events = events;
+	poll_fd.revents = 0;
+
+	return poll (&poll_fd, 1, BRASERO_JOB_IO_TIMEOUT) > 0;
+}
+
+/**
+ * Waits for data to read on fd. Returns FALSE when there was still none after
+ * a while so that the caller can check whether it should stop.
+ */
+
+gboolean
+brasero_job_io_wait_input (int fd)
+{
+	return brasero_job_io_wait (fd, POLLIN);
+}
+
+/**
+ * Pipes are enlarged (when the system allows it) so that the jobs at both
+ * ends get big reads and writes and wake up less often.
+ */
+
+void
+brasero_job_io_set_pipe_size (int fd,
+			      gint size)
+{
+#ifdef F_SETPIPE_SZ
+
+	if (fcntl (fd, F_SETPIPE_SZ, size) == -1)
+		BRASERO_BURN_LOG ("Pipe size could not be set (%s)", g_strerror (errno));
+
+#endif
+}
+
+/**
+ * Writes bytes from buffer to fd. With non blocking descriptors it waits in
+ * poll () for the reader to make room instead of spinning.
+ * Returns BRASERO_BURN_OK once everything was written and BRASERO_BURN_RETRY
+ * if the descriptor was not ready in time; the caller should then check for
+ * cancellation and call again for the rest (written is set in both cases).
+ */
+
+BraseroBurnResult
+brasero_job_io_write (int fd,
+		      gconstpointer buffer,
+		      gsize bytes,
+		      gsize *written,
+		      GError **error)
+{
+	gsize total = 0;
+
+	while (total < bytes) {
+		gssize result;
+		int errsv;
+
+		result = write (fd, (const gchar *) buffer + total, bytes - total);
+		if (result >= 0) {
+			total += result;
+			continue;
+		}
+
+		errsv = errno;
+		if (errsv == EINTR)
+			continue;
+
+		if (errsv == EAGAIN) {
+			if (brasero_job_io_wait (fd, POLLOUT))
+				continue;
+
+			if (written)
+				*written = total;
+
+			return BRASERO_BURN_RETRY;
+		}
+
+		if (written)
+			*written = total;
+
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("Data could not be written (%s)"),
+			     g_strerror (errsv));
+		return BRASERO_BURN_ERR;
+	}
+
+	if (written)
+		*written = total;
+
+	return BRASERO_BURN_OK;
+}
+
+/**
+ * Duplicates at most bytes of the data waiting in the pipe fd_in into the
+ * pipe fd_out without consuming it nor copying it to user space. The caller
+ * then reads the same amount from fd_in if it needs the data.
+ * copied is set to 0 at the end of the stream.
+ * Returns BRASERO_BURN_NOT_SUPPORTED if either descriptor is not a pipe or the
+ * system has no tee (); the data must then be written the usual way.
+ */
+
+BraseroBurnResult
+brasero_job_io_tee (int fd_in,
+		    int fd_out,
+		    gsize bytes,
+		    gsize *copied,
+		    GError **error)
+{
+#ifdef SPLICE_F_NONBLOCK
+
+	while (1) {
+		gssize result;
+		int errsv;
+
+		result = tee (fd_in, fd_out, bytes, SPLICE_F_NONBLOCK);
+		if (result >= 0) {
+			*copied = result;
+			return BRASERO_BURN_OK;
+		}
+
+		errsv = errno;
+		if (errsv == EINTR)
+			continue;
+
+		if (errsv == EINVAL || errsv == ENOSYS)
+			return BRASERO_BURN_NOT_SUPPORTED;
+
+		if (errsv != EAGAIN) {
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     _("Data could not be written (%s)"),
+				     g_strerror (errsv));
+			return BRASERO_BURN_ERR;
+		}
+
+		/* Either the input is empty or the output is full */
+		if (!brasero_job_io_wait (fd_out, POLLOUT)
+		||  !brasero_job_io_wait (fd_in, POLLIN))
+			return BRASERO_BURN_RETRY;
+	}
+
+#endif
+
+	return BRASERO_BURN_NOT_SUPPORTED;
+}
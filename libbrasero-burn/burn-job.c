@@ -54,6 +54,7 @@
 #include "brasero-session-helper.h"
 #include "brasero-plugin-information.h"
 #include "burn-job.h"
+#include "burn-job-io.h"
 #include "burn-task-ctx.h"
 #include "burn-task-item.h"
 #include "libbrasero-marshal.h"
@@ -771,6 +772,8 @@ brasero_job_item_start (BraseroTaskItem *item,
 			return BRASERO_BURN_ERR;
 		}
 
+		brasero_job_io_set_pipe_size (fd [1], BRASERO_JOB_IO_PIPE_SIZE);
+
 		/* NOTE: don't set O_NONBLOCK automatically as some plugins 
 		 * don't like that (genisoimage, mkisofs) */
 		priv->input = g_new0 (BraseroJobInput, 1);
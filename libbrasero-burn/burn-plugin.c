@@ -33,11 +33,14 @@
 #endif
 
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <glib.h>
 #include <glib-object.h>
 #include <gmodule.h>
 #include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
 
 #include <gst/gst.h>
 
@@ -146,6 +149,16 @@ enum
 static GTypeModuleClass* parent_class = NULL;
 static guint plugin_signals [LAST_SIGNAL] = { 0 };
 
+/* Output of the programs run by brasero_plugin_test_app () to get their
+ * version. It is kept across sessions so that none of them is run again as
+ * long as the binary does not change. */
+#define BRASERO_PLUGIN_APP_CACHE_FILE		"plugin-apps.cache"
+#define BRASERO_PLUGIN_APP_CACHE_MTIME		"mtime"
+#define BRASERO_PLUGIN_APP_CACHE_SIZE		"size"
+
+static GKeyFile *app_cache = NULL;
+static gboolean app_cache_dirty = FALSE;
+
 static void
 brasero_plugin_error_free (BraseroPluginError *error)
 {
@@ -188,6 +201,167 @@ brasero_plugin_test_gstreamer_plugin (BraseroPlugin *plugin,
 		gst_object_unref (element);
 }
 
+static gchar *
+brasero_plugin_app_cache_get_path (void)
+{
+	return g_build_filename (g_get_user_cache_dir (),
+				 "brasero",
+				 BRASERO_PLUGIN_APP_CACHE_FILE,
+				 NULL);
+}
+
+static GKeyFile *
+brasero_plugin_app_cache_get (void)
+{
+	gchar *path;
+
+	if (app_cache)
+		return app_cache;
+
+	app_cache = g_key_file_new ();
+
+	path = brasero_plugin_app_cache_get_path ();
+	if (!g_key_file_load_from_file (app_cache, path, G_KEY_FILE_NONE, NULL))
+		BRASERO_BURN_LOG ("No valid application cache at %s", path);
+
+	g_free (path);
+	return app_cache;
+}
+
+static void
+brasero_plugin_app_cache_save (void)
+{
+	GError *error = NULL;
+	gchar *directory;
+	gchar *contents;
+	gchar *path;
+	gsize size;
+
+	if (!app_cache || !app_cache_dirty)
+		return;
+
+	app_cache_dirty = FALSE;
+
+	contents = g_key_file_to_data (app_cache, &size, NULL);
+	path = brasero_plugin_app_cache_get_path ();
+
+	directory = g_path_get_dirname (path);
+	g_mkdir_with_parents (directory, S_IRWXU);
+	g_free (directory);
+
+	if (!g_file_set_contents (path, contents, size, &error)) {
+		BRASERO_BURN_LOG ("Application cache could not be saved (%s)", error->message);
+		g_error_free (error);
+	}
+
+	g_free (contents);
+	g_free (path);
+}
+
+/* Paths may contain characters like '[' or ']' that are not allowed in group
+ * names or may not be UTF-8 so they are escaped. Same for the keys. */
+static gchar *
+brasero_plugin_app_cache_group (const gchar *prog_path)
+{
+	return g_uri_escape_string (prog_path, NULL, FALSE);
+}
+
+static gchar *
+brasero_plugin_app_cache_key (const gchar *version_arg,
+			      const gchar *suffix)
+{
+	gchar *escaped;
+	gchar *key;
+
+	escaped = g_uri_escape_string (version_arg, NULL, FALSE);
+	key = g_strconcat (escaped, ".", suffix, NULL);
+	g_free (escaped);
+	return key;
+}
+
+/* The output is only valid if the program has the same modification time and
+ * size as when it was run. */
+static gboolean
+brasero_plugin_app_cache_lookup (const gchar *prog_path,
+				 struct stat *info,
+				 const gchar *version_arg,
+				 gchar **standard_output,
+				 gchar **standard_error)
+{
+	GKeyFile *cache;
+	gboolean result;
+	gchar *out_key;
+	gchar *err_key;
+	gchar *group;
+
+	cache = brasero_plugin_app_cache_get ();
+	group = brasero_plugin_app_cache_group (prog_path);
+	if (!g_key_file_has_group (cache, group)) {
+		g_free (group);
+		return FALSE;
+	}
+
+	if (g_key_file_get_int64 (cache, group, BRASERO_PLUGIN_APP_CACHE_MTIME, NULL) != (gint64) info->st_mtime
+	||  g_key_file_get_int64 (cache, group, BRASERO_PLUGIN_APP_CACHE_SIZE, NULL) != (gint64) info->st_size) {
+		BRASERO_BURN_LOG ("%s changed since it was last run", prog_path);
+		g_key_file_remove_group (cache, group, NULL);
+		app_cache_dirty = TRUE;
+		g_free (group);
+		return FALSE;
+	}
+
+	out_key = brasero_plugin_app_cache_key (version_arg, "stdout");
+	err_key = brasero_plugin_app_cache_key (version_arg, "stderr");
+
+	result = g_key_file_has_key (cache, group, out_key, NULL)
+	      && g_key_file_has_key (cache, group, err_key, NULL);
+
+	if (result) {
+		*standard_output = g_key_file_get_string (cache, group, out_key, NULL);
+		*standard_error = g_key_file_get_string (cache, group, err_key, NULL);
+	}
+
+	g_free (out_key);
+	g_free (err_key);
+	g_free (group);
+	return result;
+}
+
+static void
+brasero_plugin_app_cache_store (const gchar *prog_path,
+				struct stat *info,
+				const gchar *version_arg,
+				const gchar *standard_output,
+				const gchar *standard_error)
+{
+	GKeyFile *cache;
+	gchar *out_key;
+	gchar *err_key;
+	gchar *group;
+
+	/* Key files are UTF-8 only */
+	if ((standard_output && !g_utf8_validate (standard_output, -1, NULL))
+	||  (standard_error && !g_utf8_validate (standard_error, -1, NULL)))
+		return;
+
+	cache = brasero_plugin_app_cache_get ();
+	group = brasero_plugin_app_cache_group (prog_path);
+	g_key_file_set_int64 (cache, group, BRASERO_PLUGIN_APP_CACHE_MTIME, info->st_mtime);
+	g_key_file_set_int64 (cache, group, BRASERO_PLUGIN_APP_CACHE_SIZE, info->st_size);
+
+	out_key = brasero_plugin_app_cache_key (version_arg, "stdout");
+	err_key = brasero_plugin_app_cache_key (version_arg, "stderr");
+
+	g_key_file_set_string (cache, group, out_key, standard_output ? standard_output:"");
+	g_key_file_set_string (cache, group, err_key, standard_error ? standard_error:"");
+
+	g_free (out_key);
+	g_free (err_key);
+	g_free (group);
+
+	app_cache_dirty = TRUE;
+}
+
 void
 brasero_plugin_test_app (BraseroPlugin *plugin,
                          const gchar *name,
@@ -198,6 +372,7 @@ brasero_plugin_test_app (BraseroPlugin *plugin,
 	gchar *standard_output = NULL;
 	gchar *standard_error = NULL;
 	guint major, minor, sub;
+	struct stat info;
 	gchar *prog_path;
 	GPtrArray *argv;
 	gboolean res;
@@ -248,7 +423,18 @@ brasero_plugin_test_app (BraseroPlugin *plugin,
 		return;
 	}
 
-	/* Check version */
+	/* Check version; first see if we already ran this very binary */
+	if (g_stat (prog_path, &info) == 0
+	&&  brasero_plugin_app_cache_lookup (prog_path,
+					     &info,
+					     version_arg,
+					     &standard_output,
+					     &standard_error)) {
+		BRASERO_BURN_LOG ("Using cached version output for %s", prog_path);
+		g_free (prog_path);
+		goto check_version;
+	}
+
 	argv = g_ptr_array_new ();
 	g_ptr_array_add (argv, prog_path);
 	g_ptr_array_add (argv, (gchar *) version_arg);
@@ -266,15 +452,25 @@ brasero_plugin_test_app (BraseroPlugin *plugin,
 	                    NULL);
 
 	g_ptr_array_free (argv, TRUE);
-	g_free (prog_path);
 
 	if (!res) {
+		g_free (prog_path);
 		brasero_plugin_add_error (plugin,
 		                          BRASERO_PLUGIN_ERROR_WRONG_APP_VERSION,
 		                          name);
 		return;
 	}
 
+	if (g_stat (prog_path, &info) == 0)
+		brasero_plugin_app_cache_store (prog_path,
+						&info,
+						version_arg,
+						standard_output,
+						standard_error);
+	g_free (prog_path);
+
+check_version:
+
 	for (i = 0; i < 3 && version [i] >= 0; i++);
 
 	if ((standard_output && sscanf (standard_output, version_format, &major, &minor, &sub) == i)
@@ -1238,6 +1434,9 @@ brasero_plugin_check_plugin_ready (BraseroPlugin *plugin)
 
 	function (BRASERO_PLUGIN (plugin));
 	g_module_close (handle);
+
+	/* Only written when a program had to be run */
+	brasero_plugin_app_cache_save ();
 }
 
 static void
@@ -69,6 +69,20 @@ static const gchar *debug_prefixes [] = {	"stdout: %s",
 typedef BraseroBurnResult	(*BraseroProcessReadFunc)	(BraseroProcess *process,
 								 const gchar *line);
 
+/* Size of the chunks read from the children output. A line longer than
+ * that is cut. */
+#define BRASERO_PROCESS_BUFFER_SIZE	16384
+
+typedef struct _BraseroProcessBuffer BraseroProcessBuffer;
+struct _BraseroProcessBuffer {
+	/* Data not handed to readfunc yet lies between start and end */
+	gchar *data;
+	gsize start;
+	gsize end;
+
+	gchar *log_format;
+};
+
 typedef struct _BraseroProcessPrivate BraseroProcessPrivate;
 struct _BraseroProcessPrivate {
 	GPtrArray *argv;
@@ -77,10 +91,10 @@ struct _BraseroProcessPrivate {
 	GError *error;
 
 	GIOChannel *std_out;
-	GString *out_buffer;
+	BraseroProcessBuffer *out_buffer;
 
 	GIOChannel *std_error;
-	GString *err_buffer;
+	BraseroProcessBuffer *err_buffer;
 
 	gchar *working_directory;
 
@@ -327,6 +341,178 @@ brasero_process_watch_child (gpointer data)
 	return FALSE;
 }
 
+/**
+ * Output of the children is read by big chunks into a buffer and split in
+ * place on every character the tools use to end a line: progress lines of
+ * cdrecord, wodim, growisofs or cdrdao end with '\r' or '\b'. Lines are handed
+ * to readfunc straight from the buffer.
+ */
+
+static BraseroProcessBuffer *
+brasero_process_buffer_new (BraseroProcess *process,
+			    gint channel_type)
+{
+	BraseroProcessBuffer *buffer;
+
+	buffer = g_new0 (BraseroProcessBuffer, 1);
+	buffer->data = g_malloc (BRASERO_PROCESS_BUFFER_SIZE + 1);
+	buffer->log_format = g_strdup_printf ("%s %s",
+					      G_OBJECT_TYPE_NAME (process),
+					      debug_prefixes [channel_type]);
+	return buffer;
+}
+
+static void
+brasero_process_buffer_free (BraseroProcessBuffer *buffer)
+{
+	g_free (buffer->data);
+	g_free (buffer->log_format);
+	g_free (buffer);
+}
+
+static BraseroProcessBuffer *
+brasero_process_get_buffer (BraseroProcess *process,
+			    gint channel_type)
+{
+	BraseroProcessPrivate *priv = BRASERO_PROCESS_PRIVATE (process);
+
+	if (channel_type == BRASERO_CHANNEL_STDERR)
+		return priv->err_buffer;
+
+	return priv->out_buffer;
+}
+
+/* Returns the number of bytes of the line terminator starting at offset, 0 if
+ * there isn't any and -1 if more data is needed to know. */
+static gint
+brasero_process_buffer_is_term (BraseroProcessBuffer *buffer,
+				gsize offset)
+{
+	switch (buffer->data [offset]) {
+	case '\b':
+	case '\n':
+	case '\r':
+	case '\0':
+		return 1;
+
+	case '\xe2':
+		/* Unicode paragraph separator (U+2029) */
+		if (buffer->end - offset < 3)
+			return -1;
+
+		if (buffer->data [offset + 1] == '\x80'
+		&&  buffer->data [offset + 2] == '\xa9')
+			return 3;
+
+		return 0;
+
+	default:
+		return 0;
+	}
+}
+
+static BraseroBurnResult
+brasero_process_buffer_line (BraseroProcess *process,
+			     BraseroProcessBuffer *buffer,
+			     gchar *line,
+			     BraseroProcessReadFunc readfunc)
+{
+	/* Empty lines come from "\r\n" or "\b\b" sequences */
+	if (line [0] == '\0')
+		return BRASERO_BURN_OK;
+
+	brasero_job_log_message (BRASERO_JOB (process),
+				 G_STRLOC,
+				 buffer->log_format,
+				 line);
+
+	if (!readfunc)
+		return BRASERO_BURN_OK;
+
+	return readfunc (process, line);
+}
+
+/* Hands every complete line in the buffer to readfunc. The start of the
+ * pending data is moved past a line before readfunc is called: if the
+ * subclass stops the process, brasero_process_stop reads what remains in
+ * the buffer and the pipe and that must not include this line again.
+ * Returns FALSE if the buffer was freed meanwhile or if there was an error. */
+static gboolean
+brasero_process_buffer_split (BraseroProcess *process,
+			      gint channel_type,
+			      BraseroProcessReadFunc readfunc,
+			      gboolean flush)
+{
+	BraseroProcessBuffer *buffer;
+	gsize offset;
+
+	buffer = brasero_process_get_buffer (process, channel_type);
+	offset = buffer->start;
+	while (offset < buffer->end) {
+		BraseroBurnResult result;
+		gchar *line;
+		gint term;
+
+		term = brasero_process_buffer_is_term (buffer, offset);
+		if (term < 0 && flush)
+			term = 0;
+
+		if (term < 0)
+			break;
+
+		if (!term) {
+			offset ++;
+			continue;
+		}
+
+		buffer->data [offset] = '\0';
+		line = buffer->data + buffer->start;
+		buffer->start = offset + term;
+
+		result = brasero_process_buffer_line (process,
+						      buffer,
+						      line,
+						      readfunc);
+
+		/* a subclass could have stopped or errored out.
+		 * in this case brasero_process_stop will have 
+		 * been called and the buffer deallocated. So we
+		 * check that it still exists */
+		buffer = brasero_process_get_buffer (process, channel_type);
+		if (!buffer || result != BRASERO_BURN_OK)
+			return FALSE;
+
+		offset = buffer->start;
+	}
+
+	if (buffer->start == buffer->end) {
+		buffer->start = 0;
+		buffer->end = 0;
+	}
+
+	/* Either there is no more data coming or the line is longer than the
+	 * buffer: hand it as is. */
+	if (buffer->end > buffer->start
+	&& (flush || (!buffer->start && buffer->end == BRASERO_PROCESS_BUFFER_SIZE))) {
+		BraseroBurnResult result;
+
+		buffer->data [buffer->end] = '\0';
+		result = brasero_process_buffer_line (process,
+						      buffer,
+						      buffer->data + buffer->start,
+						      readfunc);
+
+		buffer = brasero_process_get_buffer (process, channel_type);
+		if (!buffer || result != BRASERO_BURN_OK)
+			return FALSE;
+
+		buffer->start = 0;
+		buffer->end = 0;
+	}
+
+	return TRUE;
+}
+
 static gboolean
 brasero_process_read (BraseroProcess *process,
 		      GIOChannel *channel,
@@ -334,114 +520,75 @@ brasero_process_read (BraseroProcess *process,
 		      gint channel_type,
 		      BraseroProcessReadFunc readfunc)
 {
-	GString *buffer;
-	GIOStatus status;
-	BraseroBurnResult result = BRASERO_BURN_OK;
-	BraseroProcessPrivate *priv = BRASERO_PROCESS_PRIVATE (process);
+	int fd;
 
 	if (!channel)
 		return FALSE;
 
-	if (channel_type == BRASERO_CHANNEL_STDERR)
-		buffer = priv->err_buffer;
-	else
-		buffer = priv->out_buffer;
-
 	if (condition & G_IO_IN) {
-		gsize term;
-		gchar *line = NULL;
-
-		status = g_io_channel_read_line (channel,
-						 &line,
-						 &term,
-						 NULL,
-						 NULL);
-
-		if (status == G_IO_STATUS_AGAIN) {
-			gchar character;
-			/* there wasn't any character ending the line.
-			 * some processes (like cdrecord/cdrdao) produce an
-			 * extra character sometimes */
-			status = g_io_channel_read_chars (channel,
-							  &character,
-							  1,
-							  NULL,
-							  NULL);
-
-			if (status == G_IO_STATUS_NORMAL) {
-				g_string_append_c (buffer, character);
-
-				switch (character) {
-				case '\b':
-				case '\n':
-				case '\r':
-				case '\xe2': /* Unicode paragraph separator */
-				case '\0':
-					BRASERO_JOB_LOG (process,
-							 debug_prefixes [channel_type],
-							 buffer->str);
-
-					if (readfunc && buffer->str [0] != '\0')
-						result = readfunc (process, buffer->str);
-
-					/* a subclass could have stopped or errored out.
-					 * in this case brasero_process_stop will have 
-					 * been called and the buffer deallocated. So we
-					 * check that it still exists */
-					if (channel_type == BRASERO_CHANNEL_STDERR)
-						buffer = priv->err_buffer;
-					else
-						buffer = priv->out_buffer;
-
-					if (buffer)
-						g_string_set_size (buffer, 0);
-
-					if (result != BRASERO_BURN_OK)
-						return FALSE;
+		fd = g_io_channel_unix_get_fd (channel);
 
-					break;
-				default:
-					break;
-				}
+		/* Read until the pipe is empty: the line splitter is cheap
+		 * compared to a wake up of the main loop. */
+		while (1) {
+			BraseroProcessBuffer *buffer;
+			gssize bytes;
+			gsize room;
+
+			buffer = brasero_process_get_buffer (process, channel_type);
+			if (!buffer)
+				return FALSE;
+
+			/* Make room for the incoming data */
+			if (buffer->start && buffer->end == BRASERO_PROCESS_BUFFER_SIZE) {
+				memmove (buffer->data,
+					 buffer->data + buffer->start,
+					 buffer->end - buffer->start);
+				buffer->end -= buffer->start;
+				buffer->start = 0;
 			}
-		}
-		else if (status == G_IO_STATUS_NORMAL) {
-			if (term)
-				line [term - 1] = '\0';
 
-			g_string_append (buffer, line);
-			g_free (line);
+			room = BRASERO_PROCESS_BUFFER_SIZE - buffer->end;
+			bytes = read (fd, buffer->data + buffer->end, room);
+			if (bytes < 0) {
+				int errsv = errno;
 
-			BRASERO_JOB_LOG (process,
-					 debug_prefixes [channel_type],
-					 buffer->str);
+				if (errsv == EINTR)
+					continue;
 
-			if (readfunc && buffer->str [0] != '\0')
-				result = readfunc (process, buffer->str);
+				if (errsv == EAGAIN)
+					break;
 
-			/* a subclass could have stopped or errored out.
-			 * in this case brasero_process_stop will have 
-			 * been called and the buffer deallocated. So we
-			 * check that it still exists */
-			if (channel_type == BRASERO_CHANNEL_STDERR)
-				buffer = priv->err_buffer;
-			else
-				buffer = priv->out_buffer;
+				BRASERO_JOB_LOG (process,
+						 debug_prefixes [channel_type],
+						 g_strerror (errsv));
+				return FALSE;
+			}
 
-			if (buffer)
-				g_string_set_size (buffer, 0);
+			if (!bytes) {
+				/* Whatever was not terminated is the last
+				 * line */
+				brasero_process_buffer_split (process,
+							      channel_type,
+							      readfunc,
+							      TRUE);
+				BRASERO_JOB_LOG (process, 
+						 debug_prefixes [channel_type],
+						 "EOF");
+				return FALSE;
+			}
 
-			if (result != BRASERO_BURN_OK)
+			buffer->end += bytes;
+			if (!brasero_process_buffer_split (process,
+							   channel_type,
+							   readfunc,
+							   FALSE))
 				return FALSE;
+
+			/* The pipe was emptied */
+			if (bytes < room)
+				break;
 		}
-		else if (status == G_IO_STATUS_EOF) {
-			BRASERO_JOB_LOG (process, 
-					 debug_prefixes [channel_type],
-					 "EOF");
-			return FALSE;
-		}
-		else
-			return FALSE;
 	}
 	else if (condition & G_IO_HUP) {
 		/* only handle the HUP when we have read all available lines of output */
@@ -464,7 +611,7 @@ brasero_process_read_stderr (GIOChannel *source,
 	BraseroProcessPrivate *priv = BRASERO_PROCESS_PRIVATE (process);
 
 	if (!priv->err_buffer)
-		priv->err_buffer = g_string_new (NULL);
+		priv->err_buffer = brasero_process_buffer_new (process, BRASERO_CHANNEL_STDERR);
 
 	klass = BRASERO_PROCESS_GET_CLASS (process);
 	result = brasero_process_read (process,
@@ -481,8 +628,10 @@ brasero_process_read_stderr (GIOChannel *source,
 	g_io_channel_unref (priv->std_error);
 	priv->std_error = NULL;
 
-	g_string_free (priv->err_buffer, TRUE);
-	priv->err_buffer = NULL;
+	if (priv->err_buffer) {
+		brasero_process_buffer_free (priv->err_buffer);
+		priv->err_buffer = NULL;
+	}
 
 	/* What if the above function (brasero_process_read called
 	 * brasero_job_finished */
@@ -509,7 +658,7 @@ brasero_process_read_stdout (GIOChannel *source,
 	BraseroProcessPrivate *priv = BRASERO_PROCESS_PRIVATE (process);
 
 	if (!priv->out_buffer)
-		priv->out_buffer = g_string_new (NULL);
+		priv->out_buffer = brasero_process_buffer_new (process, BRASERO_CHANNEL_STDOUT);
 
 	klass = BRASERO_PROCESS_GET_CLASS (process);
 	result = brasero_process_read (process,
@@ -528,8 +677,10 @@ brasero_process_read_stdout (GIOChannel *source,
 		priv->std_out = NULL;
 	}
 
-	g_string_free (priv->out_buffer, TRUE);
-	priv->out_buffer = NULL;
+	if (priv->out_buffer) {
+		brasero_process_buffer_free (priv->out_buffer);
+		priv->out_buffer = NULL;
+	}
 
 	if (priv->pid
 	&& !priv->io_err
@@ -556,10 +707,8 @@ brasero_process_setup_channel (BraseroProcess *process,
 	fcntl (pipe, F_SETFL, O_NONBLOCK);
 	channel = g_io_channel_unix_new (pipe);
 
-	/* It'd be good if we were allowed to add some to the default line
-	 * separator */
-//	g_io_channel_set_line_term (channel, "\b", -1);
-
+	/* The channel is only used to watch the pipe; brasero_process_read
+	 * reads it directly. */
 	g_io_channel_set_flags (channel,
 				g_io_channel_get_flags (channel) | G_IO_FLAG_NONBLOCK,
 				NULL);
@@ -716,23 +865,17 @@ brasero_process_stop (BraseroJob *job,
 	}
 
 	if (priv->std_out) {
-		if (error && !(*error)) {
+		if (error && !(*error) && priv->out_buffer) {
 			BraseroProcessClass *klass;
 
-			/* we need to nullify the buffer since we've just read a line
-			 * that got the job to stop so if we don't do that following 
-			 * data will be appended to this line but each will provoke the
-			 * same stop every time */
-			if (priv->out_buffer)
-				g_string_set_size (priv->out_buffer, 0);
-
+			/* The line that got the job to stop was already
+			 * consumed so only the following ones are read */
 			klass = BRASERO_PROCESS_GET_CLASS (process);
-			while (priv->std_out && g_io_channel_get_buffer_condition (priv->std_out) == G_IO_IN)
-				brasero_process_read (process,
-						      priv->std_out,
-						      G_IO_IN,
-						      BRASERO_CHANNEL_STDOUT,
-						      klass->stdout_func);
+			brasero_process_read (process,
+					      priv->std_out,
+					      G_IO_IN,
+					      BRASERO_CHANNEL_STDOUT,
+					      klass->stdout_func);
 		}
 
 	    	/* NOTE: we already checked if priv->std_out wasn't 
@@ -744,7 +887,7 @@ brasero_process_stop (BraseroJob *job,
 	}
 
 	if (priv->out_buffer) {
-		g_string_free (priv->out_buffer, TRUE);
+		brasero_process_buffer_free (priv->out_buffer);
 		priv->out_buffer = NULL;
 	}
 
@@ -754,23 +897,17 @@ brasero_process_stop (BraseroJob *job,
 	}
 
 	if (priv->std_error) {
-		if (error && !(*error)) {
+		if (error && !(*error) && priv->err_buffer) {
 			BraseroProcessClass *klass;
-		
-			/* we need to nullify the buffer since we've just read a line
-			 * that got the job to stop so if we don't do that following 
-			 * data will be appended to this line but each will provoke the
-			 * same stop every time */
-			if (priv->err_buffer)
-				g_string_set_size (priv->err_buffer, 0);
 
+			/* The line that got the job to stop was already
+			 * consumed so only the following ones are read */
 			klass = BRASERO_PROCESS_GET_CLASS (process);
-			while (priv->std_error && g_io_channel_get_buffer_condition (priv->std_error) == G_IO_IN)
-				brasero_process_read (process,
-						     priv->std_error,
-						     G_IO_IN,
-						     BRASERO_CHANNEL_STDERR,
-						     klass->stderr_func);
+			brasero_process_read (process,
+					      priv->std_error,
+					      G_IO_IN,
+					      BRASERO_CHANNEL_STDERR,
+					      klass->stderr_func);
 		}
 
 	    	/* NOTE: we already checked if priv->std_out wasn't 
@@ -782,7 +919,7 @@ brasero_process_stop (BraseroJob *job,
 	}
 
 	if (priv->err_buffer) {
-		g_string_free (priv->err_buffer, TRUE);
+		brasero_process_buffer_free (priv->err_buffer);
 		priv->err_buffer = NULL;
 	}
 
@@ -839,7 +976,7 @@ brasero_process_finalize (GObject *object)
 	}
 
 	if (priv->out_buffer) {
-		g_string_free (priv->out_buffer, TRUE);
+		brasero_process_buffer_free (priv->out_buffer);
 		priv->out_buffer = NULL;
 	}
 
@@ -854,7 +991,7 @@ brasero_process_finalize (GObject *object)
 	}
 
 	if (priv->err_buffer) {
-		g_string_free (priv->err_buffer, TRUE);
+		brasero_process_buffer_free (priv->err_buffer);
 		priv->err_buffer = NULL;
 	}
 
@@ -536,6 +536,10 @@ brasero_iso9660_read_directory_record (BraseroIsoCtx *ctx,
 	else
 		address = brasero_iso9660_get_733_val (record->address);
 
+	/* store the address of contents for later use (it's also used to
+	 * identify the directory when the whole hierarchy is loaded) */
+	directory->specific.dir.address = address;
+
 	/* load contents if recursive */
 	if (recursive) {
 		GList *children;
@@ -558,8 +562,6 @@ brasero_iso9660_read_directory_record (BraseroIsoCtx *ctx,
 		directory->isdir_loaded = TRUE;
 		directory->specific.dir.children = children;
 	}
-	else	/* store the address of contents for later use */
-		directory->specific.dir.address = address;
 
 	BRASERO_MEDIA_LOG ("New directory %s", directory->name);
 	return directory;
@@ -787,6 +789,7 @@ brasero_iso9660_get_contents (BraseroVolSrc *vol,
 							   record,
 							   TRUE);
 	volfile->specific.dir.children = children;
+	volfile->isdir_loaded = TRUE;
 
 	if (ctx.spare_record)
 		g_free (ctx.spare_record);
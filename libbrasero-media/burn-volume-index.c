@@ -0,0 +1,204 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "burn-volume-source.h"
+#include "burn-volume.h"
+#include "burn-volume-index.h"
+#include "brasero-media-private.h"
+
+struct _BraseroVolIndex {
+	BraseroVolFile *root;
+
+	/* path (gchar *) => BraseroVolFile */
+	GHashTable *paths;
+
+	/* address => BraseroVolFile (directories only) */
+	GHashTable *directories;
+
+	guint file_num;
+
+	gint ref;
+};
+
+static void
+brasero_volume_index_add_directory (BraseroVolIndex *index,
+				    BraseroVolFile *directory,
+				    const gchar *parent_path)
+{
+	GList *iter;
+
+	for (iter = directory->specific.dir.children; iter; iter = iter->next) {
+		BraseroVolFile *file;
+		const gchar *name;
+		gchar *path;
+
+		file = iter->data;
+		name = BRASERO_VOLUME_FILE_NAME (file);
+		path = g_strconcat (parent_path, "/", name, NULL);
+
+		/* Without Rock Ridge names the ISO names carry a version
+		 * number (";1") that is never part of the paths we are asked
+		 * for; index the file under both names. */
+		if (!file->rr_name) {
+			gchar *version;
+
+			version = strrchr (name, ';');
+			if (version) {
+				gchar *no_version;
+
+				no_version = g_strndup (path, strlen (path) - strlen (version));
+				if (!g_hash_table_lookup (index->paths, no_version))
+					g_hash_table_insert (index->paths, no_version, file);
+				else
+					g_free (no_version);
+			}
+		}
+
+		index->file_num ++;
+
+		if (file->isdir) {
+			g_hash_table_insert (index->directories,
+					     GINT_TO_POINTER (file->specific.dir.address),
+					     file);
+
+			brasero_volume_index_add_directory (index, file, path);
+		}
+
+		/* NOTE: the hash table takes ownership of path */
+		g_hash_table_insert (index->paths, path, file);
+	}
+}
+
+/**
+ * brasero_volume_index_new:
+ * @vol: a #BraseroVolSrc
+ * @volume_start_block: the address of the volume
+ * @error: a #GError
+ *
+ * Loads the whole directory hierarchy of the volume at @volume_start_block
+ * (including Rock Ridge names, relocated directories and multi extent files)
+ * in one pass and indexes it.
+ *
+ * Return value: a #BraseroVolIndex or NULL on error.
+ **/
+
+BraseroVolIndex *
+brasero_volume_index_new (BraseroVolSrc *vol,
+			  gint64 volume_start_block,
+			  GError **error)
+{
+	BraseroVolIndex *index;
+	BraseroVolFile *root;
+
+	root = brasero_volume_get_files (vol,
+					 volume_start_block,
+					 NULL,
+					 NULL,
+					 NULL,
+					 error);
+	if (!root)
+		return NULL;
+
+	index = g_new0 (BraseroVolIndex, 1);
+	index->ref = 1;
+	index->root = root;
+	index->paths = g_hash_table_new_full (g_str_hash,
+					      g_str_equal,
+					      g_free,
+					      NULL);
+	index->directories = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	g_hash_table_insert (index->paths, g_strdup ("/"), root);
+	brasero_volume_index_add_directory (index, root, "");
+
+	BRASERO_MEDIA_LOG ("Volume index created (%i files)", index->file_num);
+	return index;
+}
+
+BraseroVolIndex *
+brasero_volume_index_ref (BraseroVolIndex *index)
+{
+	g_return_val_if_fail (index != NULL, NULL);
+
+	g_atomic_int_inc (&index->ref);
+	return index;
+}
+
+void
+brasero_volume_index_unref (BraseroVolIndex *index)
+{
+	if (!index)
+		return;
+
+	if (!g_atomic_int_dec_and_test (&index->ref))
+		return;
+
+	g_hash_table_destroy (index->paths);
+	g_hash_table_destroy (index->directories);
+	brasero_volume_file_free (index->root);
+	g_free (index);
+}
+
+BraseroVolFile *
+brasero_volume_index_get_file (BraseroVolIndex *index,
+			       const gchar *path)
+{
+	g_return_val_if_fail (index != NULL, NULL);
+	g_return_val_if_fail (path != NULL, NULL);
+
+	return g_hash_table_lookup (index->paths, path);
+}
+
+BraseroVolFile *
+brasero_volume_index_get_directory (BraseroVolIndex *index,
+				    gint64 address)
+{
+	g_return_val_if_fail (index != NULL, NULL);
+
+	if (address <= 0)
+		return index->root;
+
+	return g_hash_table_lookup (index->directories, GINT_TO_POINTER (address));
+}
+
+guint
+brasero_volume_index_get_file_num (BraseroVolIndex *index)
+{
+	g_return_val_if_fail (index != NULL, 0);
+	return index->file_num;
+}
@@ -0,0 +1,82 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#include <glib.h>
+
+#ifndef _BURN_VOLUME_INDEX_H
+#define _BURN_VOLUME_INDEX_H
+
+#include "burn-volume.h"
+#include "burn-volume-source.h"
+
+G_BEGIN_DECLS
+
+/**
+ * The whole directory hierarchy of a volume loaded in one pass and hashed by
+ * path (and by address for directories) so that repeated lookups do not need
+ * to go back to the volume source.
+ * It is immutable once created and can be shared between threads.
+ */
+
+typedef struct _BraseroVolIndex BraseroVolIndex;
+
+BraseroVolIndex *
+brasero_volume_index_new (BraseroVolSrc *vol,
+			  gint64 volume_start_block,
+			  GError **error);
+
+BraseroVolIndex *
+brasero_volume_index_ref (BraseroVolIndex *index);
+
+void
+brasero_volume_index_unref (BraseroVolIndex *index);
+
+/**
+ * The returned BraseroVolFile belongs to the index.
+ */
+
+BraseroVolFile *
+brasero_volume_index_get_file (BraseroVolIndex *index,
+			       const gchar *path);
+
+/**
+ * Address <= 0 for root
+ */
+
+BraseroVolFile *
+brasero_volume_index_get_directory (BraseroVolIndex *index,
+				    gint64 address);
+
+guint
+brasero_volume_index_get_file_num (BraseroVolIndex *index);
+
+G_END_DECLS
+
+#endif /* _BURN_VOLUME_INDEX_H */
@@ -34,6 +34,7 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "burn-volume-source.h"
@@ -116,6 +117,93 @@ brasero_volume_source_read_fd (BraseroVolSrc *src,
 	return TRUE;
 }
 
+/**
+ * Big reads are split into several commands that are queued on the device so
+ * that the drive has always got the next one to process while we reap the
+ * previous one.
+ */
+
+#define BRASERO_VOL_SRC_QUEUED_BLOCKS		32
+#define BRASERO_VOL_SRC_QUEUED_DEPTH		4
+
+static gboolean
+brasero_volume_source_read_queued (BraseroVolSrc *src,
+				   gchar *buffer,
+				   guint blocks,
+				   gboolean readcd)
+{
+	BraseroScsiErrCode code = BRASERO_SCSI_ERROR_NONE;
+	BraseroScsiResult result;
+	gboolean success = TRUE;
+	guint command_blocks;
+	guint issued = 0;
+	guint done = 0;
+
+	/* Commands must not be bigger than what the device accepts */
+	command_blocks = MIN (BRASERO_VOL_SRC_QUEUED_BLOCKS,
+			      brasero_volume_source_get_max_transfer (src));
+
+	while (done < blocks) {
+		gpointer data = NULL;
+
+		/* Keep the queue full */
+		while (success
+		&&     issued < blocks
+		&&     brasero_device_handle_get_pending (src->data) < BRASERO_VOL_SRC_QUEUED_DEPTH) {
+			guint num;
+
+			num = MIN (command_blocks, blocks - issued);
+			if (readcd)
+				result = brasero_mmc1_read_block_async (src->data,
+									TRUE,
+									src->data_mode,
+									BRASERO_SCSI_BLOCK_HEADER_NONE,
+									BRASERO_SCSI_BLOCK_NO_SUBCHANNEL,
+									src->position + issued,
+									num,
+									(unsigned char *) buffer + issued * ISO9660_BLOCK_SIZE,
+									num * ISO9660_BLOCK_SIZE,
+									GUINT_TO_POINTER (num),
+									&code);
+			else
+				result = brasero_sbc_read10_block_async (src->data,
+									 src->position + issued,
+									 num,
+									 (unsigned char *) buffer + issued * ISO9660_BLOCK_SIZE,
+									 num * ISO9660_BLOCK_SIZE,
+									 GUINT_TO_POINTER (num),
+									 &code);
+
+			if (result != BRASERO_SCSI_OK) {
+				success = FALSE;
+				break;
+			}
+
+			issued += num;
+		}
+
+		if (!brasero_device_handle_get_pending (src->data))
+			break;
+
+		/* NOTE: even after a failure all commands must be reaped since
+		 * they write into buffer */
+		result = brasero_device_handle_wait_completion (src->data, &data, &code);
+		if (result != BRASERO_SCSI_OK)
+			success = FALSE;
+		else
+			done += GPOINTER_TO_UINT (data);
+	}
+
+	if (!success || done != blocks) {
+		BRASERO_MEDIA_LOG ("Queued read failed at %i (%s)",
+				   src->position,
+				   brasero_scsi_strerror (code));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 static gboolean
 brasero_volume_source_readcd_device_handle (BraseroVolSrc *src,
 					    gchar *buffer,
@@ -125,6 +213,12 @@ brasero_volume_source_readcd_device_handle (BraseroVolSrc *src,
 	BraseroScsiResult result;
 	BraseroScsiErrCode code;
 
+	if (blocks > BRASERO_VOL_SRC_QUEUED_BLOCKS
+	&&  brasero_volume_source_read_queued (src, buffer, blocks, TRUE)) {
+		src->position += blocks;
+		return TRUE;
+	}
+
 	BRASERO_MEDIA_LOG ("Using READCD. Reading with track mode %i", src->data_mode);
 	result = brasero_mmc1_read_block (src->data,
 					  TRUE,
@@ -192,6 +286,12 @@ brasero_volume_source_read10_device_handle (BraseroVolSrc *src,
 	BraseroScsiResult result;
 	BraseroScsiErrCode code;
 
+	if (blocks > BRASERO_VOL_SRC_QUEUED_BLOCKS
+	&&  brasero_volume_source_read_queued (src, buffer, blocks, FALSE)) {
+		src->position += blocks;
+		return TRUE;
+	}
+
 	BRASERO_MEDIA_LOG ("Using READ10");
 	result = brasero_sbc_read10_block (src->data,
 					   src->position,
@@ -216,6 +316,389 @@ brasero_volume_source_read10_device_handle (BraseroVolSrc *src,
 	return FALSE;
 }
 
+/**
+ * Caching source: it wraps another source and keeps the last blocks read in
+ * memory (by chunks of BRASERO_VOL_SRC_CACHE_CHUNK blocks). When it has to go
+ * to the wrapped source it also reads ahead the following chunks; that
+ * window grows as long as reads are sequential.
+ */
+
+#define BRASERO_VOL_SRC_CACHE_CHUNK		16
+#define BRASERO_VOL_SRC_CACHE_CHUNK_SIZE	(BRASERO_VOL_SRC_CACHE_CHUNK * ISO9660_BLOCK_SIZE)
+#define BRASERO_VOL_SRC_CACHE_MAX_READAHEAD	16	/* in chunks = 512 KiB */
+
+struct _BraseroVolSrcCacheChunk {
+	guint index;
+	GList *lru;
+	gchar data [BRASERO_VOL_SRC_CACHE_CHUNK_SIZE];
+};
+typedef struct _BraseroVolSrcCacheChunk BraseroVolSrcCacheChunk;
+
+struct _BraseroVolSrcCache {
+	BraseroVolSrc *src;
+
+	/* chunk index => BraseroVolSrcCacheChunk */
+	GHashTable *chunks;
+
+	/* most recently used first */
+	GQueue *lru;
+	guint max_chunks;
+
+	/* in chunks */
+	guint readahead;
+	guint64 next_block;
+
+	guint64 hits;
+	guint64 misses;
+	guint64 reads;
+};
+typedef struct _BraseroVolSrcCache BraseroVolSrcCache;
+
+static gint64
+brasero_volume_source_seek_cache (BraseroVolSrc *src,
+				  guint block,
+				  gint whence,
+				  GError **error)
+{
+	gint64 oldpos;
+
+	oldpos = src->position;
+
+	if (whence == SEEK_CUR)
+		src->position += block;
+	else if (whence == SEEK_SET)
+		src->position = block;
+
+	return oldpos;
+}
+
+static gboolean
+brasero_volume_source_cache_read_real (BraseroVolSrcCache *cache,
+				       gchar *buffer,
+				       guint64 block,
+				       guint blocks,
+				       GError **error)
+{
+	cache->reads ++;
+
+	if (BRASERO_VOL_SRC_SEEK (cache->src, block, SEEK_SET, error) == -1)
+		return FALSE;
+
+	return BRASERO_VOL_SRC_READ (cache->src, buffer, blocks, error);
+}
+
+static void
+brasero_volume_source_cache_insert (BraseroVolSrcCache *cache,
+				    guint index,
+				    const gchar *data)
+{
+	BraseroVolSrcCacheChunk *chunk;
+
+	if (g_hash_table_size (cache->chunks) >= cache->max_chunks) {
+		/* recycle the least recently used chunk */
+		chunk = g_queue_pop_tail (cache->lru);
+		g_hash_table_remove (cache->chunks, GUINT_TO_POINTER (chunk->index));
+	}
+	else
+		chunk = g_new (BraseroVolSrcCacheChunk, 1);
+
+	chunk->index = index;
+	memcpy (chunk->data, data, BRASERO_VOL_SRC_CACHE_CHUNK_SIZE);
+
+	g_queue_push_head (cache->lru, chunk);
+	chunk->lru = cache->lru->head;
+	g_hash_table_insert (cache->chunks, GUINT_TO_POINTER (index), chunk);
+}
+
+static BraseroVolSrcCacheChunk *
+brasero_volume_source_cache_get_chunk (BraseroVolSrcCache *cache,
+				       guint index)
+{
+	BraseroVolSrcCacheChunk *chunk;
+	gchar *buffer;
+	guint num;
+	guint i;
+
+	chunk = g_hash_table_lookup (cache->chunks, GUINT_TO_POINTER (index));
+	if (chunk) {
+		cache->hits ++;
+
+		/* move it to the head of the queue */
+		g_queue_unlink (cache->lru, chunk->lru);
+		g_queue_push_head_link (cache->lru, chunk->lru);
+		return chunk;
+	}
+
+	cache->misses ++;
+
+	/* read ahead all the following chunks not in cache yet */
+	for (num = 1; num < cache->readahead; num ++) {
+		if (g_hash_table_lookup (cache->chunks, GUINT_TO_POINTER (index + num)))
+			break;
+	}
+
+	buffer = g_malloc (num * BRASERO_VOL_SRC_CACHE_CHUNK_SIZE);
+	if (!brasero_volume_source_cache_read_real (cache,
+						    buffer,
+						    (guint64) index * BRASERO_VOL_SRC_CACHE_CHUNK,
+						    num * BRASERO_VOL_SRC_CACHE_CHUNK,
+						    NULL)) {
+		/* We may have tried to read past the end of the volume */
+		num = 1;
+		if (!brasero_volume_source_cache_read_real (cache,
+							    buffer,
+							    (guint64) index * BRASERO_VOL_SRC_CACHE_CHUNK,
+							    BRASERO_VOL_SRC_CACHE_CHUNK,
+							    NULL)) {
+			g_free (buffer);
+			return NULL;
+		}
+	}
+
+	/* insert them in reverse order so that the one requested is the most
+	 * recently used */
+	for (i = num; i > 0; i --)
+		brasero_volume_source_cache_insert (cache,
+						    index + i - 1,
+						    buffer + (i - 1) * BRASERO_VOL_SRC_CACHE_CHUNK_SIZE);
+	g_free (buffer);
+
+	return g_hash_table_lookup (cache->chunks, GUINT_TO_POINTER (index));
+}
+
+static gboolean
+brasero_volume_source_read_cache (BraseroVolSrc *src,
+				  gchar *buffer,
+				  guint blocks,
+				  GError **error)
+{
+	BraseroVolSrcCache *cache;
+	guint done = 0;
+
+	cache = src->data;
+
+	/* Adapt the read ahead window */
+	if (src->position == cache->next_block)
+		cache->readahead = MIN (cache->readahead * 2, BRASERO_VOL_SRC_CACHE_MAX_READAHEAD);
+	else
+		cache->readahead = 1;
+
+	/* Big reads are not worth caching */
+	if (blocks >= BRASERO_VOL_SRC_CACHE_MAX_READAHEAD * BRASERO_VOL_SRC_CACHE_CHUNK)
+		goto direct;
+
+	while (done < blocks) {
+		BraseroVolSrcCacheChunk *chunk;
+		guint64 block;
+		guint offset;
+		guint num;
+
+		block = src->position + done;
+		chunk = brasero_volume_source_cache_get_chunk (cache, block / BRASERO_VOL_SRC_CACHE_CHUNK);
+		if (!chunk)
+			goto direct;
+
+		offset = block % BRASERO_VOL_SRC_CACHE_CHUNK;
+		num = MIN (BRASERO_VOL_SRC_CACHE_CHUNK - offset, blocks - done);
+		memcpy (buffer + done * ISO9660_BLOCK_SIZE,
+			chunk->data + offset * ISO9660_BLOCK_SIZE,
+			num * ISO9660_BLOCK_SIZE);
+
+		done += num;
+	}
+
+	src->position += blocks;
+	cache->next_block = src->position;
+	return TRUE;
+
+direct:
+
+	/* Read whatever remains straight from the wrapped source */
+	if (!brasero_volume_source_cache_read_real (cache,
+						    buffer + done * ISO9660_BLOCK_SIZE,
+						    src->position + done,
+						    blocks - done,
+						    error))
+		return FALSE;
+
+	src->position += blocks;
+	cache->next_block = src->position;
+	return TRUE;
+}
+
+static void
+brasero_volume_source_cache_free (BraseroVolSrcCache *cache)
+{
+	BRASERO_MEDIA_LOG ("Volume source cache: %" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT " misses, %" G_GUINT64_FORMAT " reads",
+			   cache->hits,
+			   cache->misses,
+			   cache->reads);
+
+	g_queue_foreach (cache->lru, (GFunc) g_free, NULL);
+	g_queue_free (cache->lru);
+	g_hash_table_destroy (cache->chunks);
+
+	brasero_volume_source_close (cache->src);
+	g_free (cache);
+}
+
+/**
+ * Transfer size tuning: the best read size depends a lot on the drive and the
+ * bus (USB, SATA, ...). Reads start small and their size is doubled as long
+ * as the throughput measured over BRASERO_VOL_SRC_TUNING_BYTES improves, up to
+ * what the device accepts.
+ */
+
+#define BRASERO_VOL_SRC_MIN_TRANSFER		16	/* 32 KiB */
+#define BRASERO_VOL_SRC_MAX_TRANSFER		512	/* 1 MiB */
+#define BRASERO_VOL_SRC_DEFAULT_TRANSFER	64	/* device doesn't tell */
+#define BRASERO_VOL_SRC_TUNING_BYTES		(1024 * 1024)
+
+struct _BraseroVolSrcTuning {
+	/* in blocks */
+	guint max_blocks;
+	guint blocks;
+	guint best_blocks;
+
+	gdouble best_rate;
+
+	/* measured for the current size */
+	guint64 bytes;
+	gint64 usecs;
+
+	guint done:1;
+};
+
+static guint
+brasero_volume_source_get_max_transfer_real (BraseroVolSrc *src)
+{
+	int bytes;
+
+	if (src->seek != brasero_volume_source_seek_device_handle)
+		return BRASERO_VOL_SRC_MAX_TRANSFER;
+
+	bytes = brasero_device_handle_get_max_transfer (src->data);
+	if (bytes <= 0)
+		return BRASERO_VOL_SRC_DEFAULT_TRANSFER;
+
+	return CLAMP (bytes / ISO9660_BLOCK_SIZE,
+		      BRASERO_VOL_SRC_MIN_TRANSFER,
+		      BRASERO_VOL_SRC_MAX_TRANSFER);
+}
+
+static BraseroVolSrcTuning *
+brasero_volume_source_get_tuning (BraseroVolSrc *src)
+{
+	BraseroVolSrcTuning *tuning;
+
+	/* Reads smaller than the read ahead window of a cache are served from
+	 * memory so the timings would not be those of the drive */
+	src = brasero_volume_source_get_uncached (src);
+	if (src->tuning)
+		return src->tuning;
+
+	tuning = g_new0 (BraseroVolSrcTuning, 1);
+	tuning->max_blocks = brasero_volume_source_get_max_transfer_real (src);
+	tuning->blocks = MIN (BRASERO_VOL_SRC_MIN_TRANSFER, tuning->max_blocks);
+	tuning->best_blocks = tuning->blocks;
+	tuning->done = (tuning->blocks >= tuning->max_blocks);
+
+	BRASERO_MEDIA_LOG ("Transfer size between %i and %i blocks",
+			   tuning->blocks,
+			   tuning->max_blocks);
+
+	src->tuning = tuning;
+	return tuning;
+}
+
+/**
+ * brasero_volume_source_get_max_transfer:
+ * @src: a #BraseroVolSrc
+ *
+ * Returns the biggest number of blocks that should be read at once from @src.
+ *
+ * Return value: a #guint
+ **/
+
+guint
+brasero_volume_source_get_max_transfer (BraseroVolSrc *src)
+{
+	g_return_val_if_fail (src != NULL, BRASERO_VOL_SRC_DEFAULT_TRANSFER);
+	return brasero_volume_source_get_tuning (src)->max_blocks;
+}
+
+/**
+ * brasero_volume_source_get_transfer:
+ * @src: a #BraseroVolSrc
+ *
+ * Returns the number of blocks that should be read at once from @src. It
+ * changes while tuning; see brasero_volume_source_transfer_done ().
+ *
+ * Return value: a #guint
+ **/
+
+guint
+brasero_volume_source_get_transfer (BraseroVolSrc *src)
+{
+	g_return_val_if_fail (src != NULL, BRASERO_VOL_SRC_DEFAULT_TRANSFER);
+	return brasero_volume_source_get_tuning (src)->blocks;
+}
+
+/**
+ * brasero_volume_source_transfer_done:
+ * @src: a #BraseroVolSrc
+ * @blocks: the number of blocks read
+ * @usecs: the time it took
+ *
+ * Reports how long a read of the size returned by
+ * brasero_volume_source_get_transfer () took so that the size can be tuned.
+ **/
+
+void
+brasero_volume_source_transfer_done (BraseroVolSrc *src,
+				     guint blocks,
+				     gint64 usecs)
+{
+	BraseroVolSrcTuning *tuning;
+	gdouble rate;
+
+	g_return_if_fail (src != NULL);
+
+	tuning = brasero_volume_source_get_tuning (src);
+	if (tuning->done)
+		return;
+
+	tuning->bytes += (guint64) blocks * ISO9660_BLOCK_SIZE;
+	tuning->usecs += usecs;
+	if (tuning->bytes < BRASERO_VOL_SRC_TUNING_BYTES)
+		return;
+
+	rate = (gdouble) tuning->bytes * G_USEC_PER_SEC / MAX (tuning->usecs, 1);
+	BRASERO_MEDIA_LOG ("Transfer size %i blocks: %.0f KiB/s",
+			   tuning->blocks,
+			   rate / 1024);
+
+	/* Go on as long as it is at least 5% better */
+	if (rate > tuning->best_rate * 1.05) {
+		tuning->best_rate = rate;
+		tuning->best_blocks = tuning->blocks;
+
+		if (tuning->blocks < tuning->max_blocks) {
+			tuning->blocks = MIN (tuning->blocks * 2, tuning->max_blocks);
+			tuning->bytes = 0;
+			tuning->usecs = 0;
+			return;
+		}
+	}
+
+	tuning->blocks = tuning->best_blocks;
+	tuning->done = TRUE;
+
+	BRASERO_MEDIA_LOG ("Transfer size set to %i blocks (%i KiB)",
+			   tuning->blocks,
+			   tuning->blocks * ISO9660_BLOCK_SIZE / 1024);
+}
+
 void
 brasero_volume_source_close (BraseroVolSrc *src)
 {
@@ -225,10 +708,102 @@ brasero_volume_source_close (BraseroVolSrc *src)
 
 	if (src->seek == brasero_volume_source_seek_fd)
 		fclose (src->data);
+	else if (src->seek == brasero_volume_source_seek_cache)
+		brasero_volume_source_cache_free (src->data);
 
+	g_free (src->tuning);
 	g_free (src);
 }
 
+/**
+ * brasero_volume_source_open_cache:
+ * @src: a #BraseroVolSrc
+ * @max_blocks: the maximum number of blocks to keep in memory
+ *
+ * Wraps @src into a new source that caches the blocks read and reads ahead
+ * when accesses are sequential. That's worth it for metadata heavy operations
+ * that read one block at a time. A reference is taken on @src.
+ *
+ * Return value: a new #BraseroVolSrc
+ **/
+
+BraseroVolSrc *
+brasero_volume_source_open_cache (BraseroVolSrc *src,
+				  guint max_blocks)
+{
+	BraseroVolSrcCache *cache;
+	BraseroVolSrc *retval;
+
+	g_return_val_if_fail (src != NULL, NULL);
+
+	cache = g_new0 (BraseroVolSrcCache, 1);
+	cache->src = src;
+	brasero_volume_source_ref (src);
+
+	cache->max_chunks = MAX (max_blocks / BRASERO_VOL_SRC_CACHE_CHUNK, BRASERO_VOL_SRC_CACHE_MAX_READAHEAD);
+	cache->chunks = g_hash_table_new (g_direct_hash, g_direct_equal);
+	cache->lru = g_queue_new ();
+	cache->readahead = 1;
+	cache->next_block = G_MAXUINT64;
+
+	retval = g_new0 (BraseroVolSrc, 1);
+	retval->ref = 1;
+	retval->data = cache;
+	retval->position = src->position;
+	retval->seek = brasero_volume_source_seek_cache;
+	retval->read = brasero_volume_source_read_cache;
+	return retval;
+}
+
+/**
+ * brasero_volume_source_get_uncached:
+ * @src: a #BraseroVolSrc
+ *
+ * Returns the source wrapped by @src if it is a caching source, @src
+ * otherwise. Bulk data (like file contents) should be read from it so that it
+ * does not evict the blocks cached for metadata. No reference is taken.
+ *
+ * Return value: a #BraseroVolSrc
+ **/
+
+BraseroVolSrc *
+brasero_volume_source_get_uncached (BraseroVolSrc *src)
+{
+	BraseroVolSrcCache *cache;
+
+	g_return_val_if_fail (src != NULL, NULL);
+
+	if (src->seek != brasero_volume_source_seek_cache)
+		return src;
+
+	cache = src->data;
+	return cache->src;
+}
+
+void
+brasero_volume_source_get_cache_stats (BraseroVolSrc *src,
+				       guint64 *hits,
+				       guint64 *misses)
+{
+	BraseroVolSrcCache *cache;
+
+	g_return_if_fail (src != NULL);
+
+	if (src->seek != brasero_volume_source_seek_cache) {
+		if (hits)
+			*hits = 0;
+		if (misses)
+			*misses = 0;
+		return;
+	}
+
+	cache = src->data;
+	if (hits)
+		*hits = cache->hits;
+	if (misses)
+		*misses = cache->misses;
+}
+
 BraseroVolSrc *
 brasero_volume_source_open_file (const gchar *path,
 				 GError **error)
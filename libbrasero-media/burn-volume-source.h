@@ -38,6 +38,7 @@
 G_BEGIN_DECLS
 
 typedef struct _BraseroVolSrc BraseroVolSrc;
+typedef struct _BraseroVolSrcTuning BraseroVolSrcTuning;
 
 typedef gboolean (*BraseroVolSrcReadFunc)	(BraseroVolSrc *src,
 						 gchar *buffer,
@@ -54,6 +55,9 @@ struct _BraseroVolSrc {
 	gpointer data;
 	guint data_mode;
 	guint ref;
+
+	/* see brasero_volume_source_get_transfer () */
+	BraseroVolSrcTuning *tuning;
 };
 
 #define BRASERO_VOL_SRC_SEEK(vol_MACRO, block_MACRO, whence_MACRO, error_MACRO)	\
@@ -73,6 +77,32 @@ BraseroVolSrc *
 brasero_volume_source_open_fd (int fd,
 			       GError **error);
 
+/* 8 MiB */
+#define BRASERO_VOL_SRC_CACHE_DEFAULT_BLOCKS	4096
+
+BraseroVolSrc *
+brasero_volume_source_open_cache (BraseroVolSrc *src,
+				  guint max_blocks);
+
+BraseroVolSrc *
+brasero_volume_source_get_uncached (BraseroVolSrc *src);
+
+void
+brasero_volume_source_get_cache_stats (BraseroVolSrc *src,
+				       guint64 *hits,
+				       guint64 *misses);
+
+guint
+brasero_volume_source_get_max_transfer (BraseroVolSrc *src);
+
+guint
+brasero_volume_source_get_transfer (BraseroVolSrc *src);
+
+void
+brasero_volume_source_transfer_done (BraseroVolSrc *src,
+				     guint blocks,
+				     gint64 usecs);
+
 void
 brasero_volume_source_ref (BraseroVolSrc *vol);
 
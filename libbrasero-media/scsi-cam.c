@@ -53,6 +53,7 @@
 #include "scsi-command.h"
 #include "scsi-utils.h"
 #include "scsi-error.h"
+#include "scsi-completion.h"
 #include "scsi-sense-data.h"
 
 /* FreeBSD's SCSI CAM interface */
@@ -63,6 +64,9 @@
 struct _BraseroDeviceHandle {
 	struct cam_device *cam;
 	int fd;
+
+	/* completions of queued commands */
+	GQueue *completed;
 };
 
 struct _BraseroScsiCmd {
@@ -132,6 +136,55 @@ brasero_scsi_command_issue_sync (gpointer command,
 	return BRASERO_SCSI_OK;
 }
 
+/**
+ * There is no way to queue commands with this interface so they are run
+ * synchronously and their completion is queued.
+ */
+
+BraseroScsiResult
+brasero_scsi_command_issue_async (gpointer command,
+				  gpointer buffer,
+				  int size,
+				  gpointer user_data,
+				  BraseroScsiErrCode *error)
+{
+	BraseroScsiCmd *cmd;
+
+	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
+
+	cmd = command;
+	return brasero_scsi_completion_queue_issue (cmd->handle->completed,
+						    cmd,
+						    buffer,
+						    size,
+						    user_data);
+}
+
+int
+brasero_device_handle_get_pending (BraseroDeviceHandle *handle)
+{
+	g_return_val_if_fail (handle != NULL, 0);
+	return g_queue_get_length (handle->completed);
+}
+
+BraseroScsiResult
+brasero_device_handle_wait_completion (BraseroDeviceHandle *handle,
+				       gpointer *user_data,
+				       BraseroScsiErrCode *error)
+{
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+	return brasero_scsi_completion_queue_wait (handle->completed,
+						   user_data,
+						   error);
+}
+
+int
+brasero_device_handle_get_max_transfer (BraseroDeviceHandle *handle)
+{
+	/* Unknown */
+	return 0;
+}
+
 gpointer
 brasero_scsi_command_new (const BraseroScsiCmdInfo *info,
 			  BraseroDeviceHandle *handle)
@@ -182,6 +235,7 @@ brasero_device_handle_open (const gchar *path,
 		handle = g_new0 (BraseroDeviceHandle, 1);
 		handle->cam = cam;
 		handle->fd = fd;
+		handle->completed = brasero_scsi_completion_queue_new ();
 	}
 	else {
 		int serrno;
@@ -215,6 +269,8 @@ brasero_device_handle_close (BraseroDeviceHandle *handle)
 {
 	g_assert (handle != NULL);
 
+	brasero_scsi_completion_queue_free (handle->completed);
+
 	if (handle->cam)
 		cam_close_device (handle->cam);
 
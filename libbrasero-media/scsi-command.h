@@ -75,6 +75,16 @@ brasero_scsi_command_issue_sync (gpointer command,
 				 gpointer buffer,
 				 int size,
 				 BraseroScsiErrCode *error);
+
+/* The command can be freed as soon as it has been issued but the buffer must
+ * stay valid until its completion has been reaped with
+ * brasero_device_handle_wait_completion () */
+BraseroScsiResult
+brasero_scsi_command_issue_async (gpointer command,
+				  gpointer buffer,
+				  int size,
+				  gpointer user_data,
+				  BraseroScsiErrCode *error);
 G_END_DECLS
 
 #endif /* _BURN_SCSI_COMMAND_H */
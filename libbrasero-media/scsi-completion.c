@@ -0,0 +1,113 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "brasero-media-private.h"
+#include "scsi-command.h"
+#include "scsi-utils.h"
+#include "scsi-error.h"
+#include "scsi-completion.h"
+
+struct _BraseroScsiCompletion {
+	gpointer user_data;
+	BraseroScsiResult result;
+	BraseroScsiErrCode code;
+};
+typedef struct _BraseroScsiCompletion BraseroScsiCompletion;
+
+GQueue *
+brasero_scsi_completion_queue_new (void)
+{
+	return g_queue_new ();
+}
+
+void
+brasero_scsi_completion_queue_free (GQueue *queue)
+{
+	if (!queue)
+		return;
+
+	g_queue_foreach (queue, (GFunc) g_free, NULL);
+	g_queue_free (queue);
+}
+
+BraseroScsiResult
+brasero_scsi_completion_queue_issue (GQueue *queue,
+				     gpointer command,
+				     gpointer buffer,
+				     int size,
+				     gpointer user_data)
+{
+	BraseroScsiCompletion *completion;
+
+	g_return_val_if_fail (queue != NULL, BRASERO_SCSI_FAILURE);
+	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
+
+	completion = g_new0 (BraseroScsiCompletion, 1);
+	completion->user_data = user_data;
+	completion->result = brasero_scsi_command_issue_sync (command,
+							      buffer,
+							      size,
+							      &completion->code);
+	g_queue_push_tail (queue, completion);
+	return BRASERO_SCSI_OK;
+}
+
+BraseroScsiResult
+brasero_scsi_completion_queue_wait (GQueue *queue,
+				    gpointer *user_data,
+				    BraseroScsiErrCode *error)
+{
+	BraseroScsiCompletion *completion;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (queue != NULL, BRASERO_SCSI_FAILURE);
+
+	completion = g_queue_pop_head (queue);
+	if (!completion) {
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	if (user_data)
+		*user_data = completion->user_data;
+
+	res = completion->result;
+	if (res != BRASERO_SCSI_OK)
+		BRASERO_SCSI_SET_ERRCODE (error, completion->code);
+
+	g_free (completion);
+	return res;
+}
@@ -0,0 +1,67 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+ 
+#ifndef _SCSI_COMPLETION_H
+#define _SCSI_COMPLETION_H
+
+#include <glib.h>
+
+#include "scsi-error.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Used by the backends that can't queue commands: these are run synchronously
+ * and their completion is stored in a queue until it is reaped.
+ */
+
+GQueue *
+brasero_scsi_completion_queue_new (void);
+
+void
+brasero_scsi_completion_queue_free (GQueue *queue);
+
+BraseroScsiResult
+brasero_scsi_completion_queue_issue (GQueue *queue,
+				     gpointer command,
+				     gpointer buffer,
+				     int size,
+				     gpointer user_data);
+
+BraseroScsiResult
+brasero_scsi_completion_queue_wait (GQueue *queue,
+				    gpointer *user_data,
+				    BraseroScsiErrCode *error);
+
+G_END_DECLS
+
+#endif /* _SCSI_COMPLETION_H */
+
+ 
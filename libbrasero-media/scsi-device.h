@@ -47,6 +47,17 @@ brasero_device_handle_open (const gchar *path,
 void
 brasero_device_handle_close (BraseroDeviceHandle *handle);
 
+int
+brasero_device_handle_get_max_transfer (BraseroDeviceHandle *handle);
+
+int
+brasero_device_handle_get_pending (BraseroDeviceHandle *handle);
+
+BraseroScsiResult
+brasero_device_handle_wait_completion (BraseroDeviceHandle *handle,
+				       gpointer *user_data,
+				       BraseroScsiErrCode *error);
+
 char *
 brasero_device_get_bus_target_lun (const gchar *device);
 
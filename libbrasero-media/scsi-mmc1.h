@@ -86,6 +86,19 @@ brasero_mmc1_read_block (BraseroDeviceHandle *handle,
 			 unsigned char *buffer,
 			 int buffer_len,
 			 BraseroScsiErrCode *error);
+
+BraseroScsiResult
+brasero_mmc1_read_block_async (BraseroDeviceHandle *handle,
+			       gboolean user_data,
+			       BraseroScsiBlockType type,
+			       BraseroScsiBlockHeader header,
+			       BraseroScsiBlockSubChannel channel,
+			       int start,
+			       int size,
+			       unsigned char *buffer,
+			       int buffer_len,
+			       gpointer callback_data,
+			       BraseroScsiErrCode *error);
 BraseroScsiResult
 brasero_mmc1_mech_status (BraseroDeviceHandle *handle,
 			  BraseroScsiMechStatusHdr *hdr,
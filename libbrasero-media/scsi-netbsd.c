@@ -50,10 +50,14 @@
 #include "scsi-command.h"
 #include "scsi-utils.h"
 #include "scsi-error.h"
+#include "scsi-completion.h"
 #include "scsi-sense-data.h"
 
 struct _BraseroDeviceHandle {
 	int fd;
+
+	/* completions of queued commands */
+	GQueue *completed;
 };
 
 struct _BraseroScsiCmd {
@@ -128,6 +132,55 @@ brasero_scsi_command_issue_sync (gpointer command,
 	return BRASERO_SCSI_FAILURE;
 }
 
+/**
+ * There is no way to queue commands with this interface so they are run
+ * synchronously and their completion is queued.
+ */
+
+BraseroScsiResult
+brasero_scsi_command_issue_async (gpointer command,
+				  gpointer buffer,
+				  int size,
+				  gpointer user_data,
+				  BraseroScsiErrCode *error)
+{
+	BraseroScsiCmd *cmd;
+
+	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
+
+	cmd = command;
+	return brasero_scsi_completion_queue_issue (cmd->handle->completed,
+						    cmd,
+						    buffer,
+						    size,
+						    user_data);
+}
+
+int
+brasero_device_handle_get_pending (BraseroDeviceHandle *handle)
+{
+	g_return_val_if_fail (handle != NULL, 0);
+	return g_queue_get_length (handle->completed);
+}
+
+BraseroScsiResult
+brasero_device_handle_wait_completion (BraseroDeviceHandle *handle,
+				       gpointer *user_data,
+				       BraseroScsiErrCode *error)
+{
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+	return brasero_scsi_completion_queue_wait (handle->completed,
+						   user_data,
+						   error);
+}
+
+int
+brasero_device_handle_get_max_transfer (BraseroDeviceHandle *handle)
+{
+	/* Unknown */
+	return 0;
+}
+
 gpointer
 brasero_scsi_command_new (const BraseroScsiCmdInfo *info,
 			  BraseroDeviceHandle *handle) 
@@ -187,6 +240,7 @@ brasero_device_handle_open (const gchar *path,
 
 	handle = g_new (BraseroDeviceHandle, 1);
 	handle->fd = fd;
+	handle->completed = brasero_scsi_completion_queue_new ();
 
 	return handle;
 }
@@ -194,6 +248,8 @@ brasero_device_handle_open (const gchar *path,
 void
 brasero_device_handle_close (BraseroDeviceHandle *handle)
 {
+	brasero_scsi_completion_queue_free (handle->completed);
+
 	close (handle->fd);
 	g_free (handle);
 }
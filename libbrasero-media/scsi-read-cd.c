@@ -103,22 +103,16 @@ BRASERO_SCSI_COMMAND_DEFINE (BraseroReadCDCDB,
 			     READ_CD,
 			     BRASERO_SCSI_READ);
 
-BraseroScsiResult
-brasero_mmc1_read_block (BraseroDeviceHandle *handle,
-			 gboolean user_data,
-			 BraseroScsiBlockType type,
-			 BraseroScsiBlockHeader header,
-			 BraseroScsiBlockSubChannel channel,
-			 int start,
-			 int size,
-			 unsigned char *buffer,
-			 int buffer_len,
-			 BraseroScsiErrCode *error)
+static BraseroReadCDCDB *
+brasero_mmc1_read_block_command_new (BraseroDeviceHandle *handle,
+				     gboolean user_data,
+				     BraseroScsiBlockType type,
+				     BraseroScsiBlockHeader header,
+				     BraseroScsiBlockSubChannel channel,
+				     int start,
+				     int size)
 {
 	BraseroReadCDCDB *cdb;
-	BraseroScsiResult res;
-
-	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
 
 	cdb = brasero_scsi_command_new (&info, handle);
 	BRASERO_SET_32 (cdb->start_lba, start);
@@ -145,6 +139,34 @@ brasero_mmc1_read_block (BraseroDeviceHandle *handle,
 	/* subchannel */
 	cdb->subchannel = channel;
 
+	return cdb;
+}
+
+BraseroScsiResult
+brasero_mmc1_read_block (BraseroDeviceHandle *handle,
+			 gboolean user_data,
+			 BraseroScsiBlockType type,
+			 BraseroScsiBlockHeader header,
+			 BraseroScsiBlockSubChannel channel,
+			 int start,
+			 int size,
+			 unsigned char *buffer,
+			 int buffer_len,
+			 BraseroScsiErrCode *error)
+{
+	BraseroReadCDCDB *cdb;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_mmc1_read_block_command_new (handle,
+						   user_data,
+						   type,
+						   header,
+						   channel,
+						   start,
+						   size);
+
 	if (buffer)
 		memset (buffer, 0, buffer_len);
 
@@ -155,3 +177,42 @@ brasero_mmc1_read_block (BraseroDeviceHandle *handle,
 	brasero_scsi_command_free (cdb);
 	return res;
 }
+
+/**
+ * Queues the read; buffer must remain valid until the completion is reaped
+ * with brasero_device_handle_wait_completion () which returns callback_data.
+ */
+
+BraseroScsiResult
+brasero_mmc1_read_block_async (BraseroDeviceHandle *handle,
+			       gboolean user_data,
+			       BraseroScsiBlockType type,
+			       BraseroScsiBlockHeader header,
+			       BraseroScsiBlockSubChannel channel,
+			       int start,
+			       int size,
+			       unsigned char *buffer,
+			       int buffer_len,
+			       gpointer callback_data,
+			       BraseroScsiErrCode *error)
+{
+	BraseroReadCDCDB *cdb;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_mmc1_read_block_command_new (handle,
+						   user_data,
+						   type,
+						   header,
+						   channel,
+						   start,
+						   size);
+	res = brasero_scsi_command_issue_async (cdb,
+						buffer,
+						buffer_len,
+						callback_data,
+						error);
+	brasero_scsi_command_free (cdb);
+	return res;
+}
@@ -90,18 +90,12 @@ BRASERO_SCSI_COMMAND_DEFINE (BraseroRead10CDB,
 			     READ10,
 			     BRASERO_SCSI_READ);
 
-BraseroScsiResult
-brasero_sbc_read10_block (BraseroDeviceHandle *handle,
-			  int start,
-			  int num_blocks,
-			  unsigned char *buffer,
-			  int buffer_size,
-			  BraseroScsiErrCode *error)
+static BraseroRead10CDB *
+brasero_sbc_read10_command_new (BraseroDeviceHandle *handle,
+				int start,
+				int num_blocks)
 {
 	BraseroRead10CDB *cdb;
-	BraseroScsiResult res;
-
-	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
 
 	cdb = brasero_scsi_command_new (&info, handle);
 	BRASERO_SET_32 (cdb->start_address, start);
@@ -116,6 +110,24 @@ brasero_sbc_read10_block (BraseroDeviceHandle *handle,
 	/* On the other hand caching improves dramatically the performances. */
 	cdb->FUA = 0;
 
+	return cdb;
+}
+
+BraseroScsiResult
+brasero_sbc_read10_block (BraseroDeviceHandle *handle,
+			  int start,
+			  int num_blocks,
+			  unsigned char *buffer,
+			  int buffer_size,
+			  BraseroScsiErrCode *error)
+{
+	BraseroRead10CDB *cdb;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_sbc_read10_command_new (handle, start, num_blocks);
+
 	memset (buffer, 0, buffer_size);
 	res = brasero_scsi_command_issue_sync (cdb,
 					       buffer,
@@ -124,3 +136,32 @@ brasero_sbc_read10_block (BraseroDeviceHandle *handle,
 	brasero_scsi_command_free (cdb);
 	return res;
 }
+
+/**
+ * Queues the read; buffer must remain valid until the completion is reaped
+ * with brasero_device_handle_wait_completion () which returns user_data.
+ */
+
+BraseroScsiResult
+brasero_sbc_read10_block_async (BraseroDeviceHandle *handle,
+				int start,
+				int num_blocks,
+				unsigned char *buffer,
+				int buffer_size,
+				gpointer user_data,
+				BraseroScsiErrCode *error)
+{
+	BraseroRead10CDB *cdb;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_sbc_read10_command_new (handle, start, num_blocks);
+	res = brasero_scsi_command_issue_async (cdb,
+						buffer,
+						buffer_size,
+						user_data,
+						error);
+	brasero_scsi_command_free (cdb);
+	return res;
+}
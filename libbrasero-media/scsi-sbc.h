@@ -52,6 +52,15 @@ brasero_sbc_read10_block (BraseroDeviceHandle *handle,
 			  int buffer_size,
 			  BraseroScsiErrCode *error);
 
+BraseroScsiResult
+brasero_sbc_read10_block_async (BraseroDeviceHandle *handle,
+				int start,
+				int num_blocks,
+				unsigned char *buffer,
+				int buffer_size,
+				gpointer user_data,
+				BraseroScsiErrCode *error);
+
 G_END_DECLS
 
 #endif /* _BURN_SBC_H */
@@ -39,7 +39,9 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <string.h>
+#include <poll.h>
 #include <sys/ioctl.h>
+#include <sys/sysmacros.h>
 
 #include <scsi/scsi.h>
 #include <scsi/sg.h>
@@ -53,7 +55,35 @@
 
 struct _BraseroDeviceHandle {
 	int fd;
+
+	/* Used for queued commands: sg write ()/read () interface only works
+	 * with the sg node (not with srX) so it may be a different fd. It is
+	 * opened the first time a queued command is issued. -2 means not yet
+	 * probed; -1 that there is no such node (commands are then run
+	 * synchronously and their completion queued). */
+	int async_fd;
+	int pack_id;
+	int pending;
+	GQueue *completed;
+
+	/* Requests written to async_fd and not read back yet */
+	GList *in_flight;
+};
+
+/* One queued command. The CDB and the sense buffer are kept here since they
+ * must remain valid until completion. */
+struct _BraseroSgRequest {
+	struct sg_io_hdr transport;
+	uchar cmd [BRASERO_SCSI_CMD_MAX_LEN];
+	uchar sense_buffer [BRASERO_SENSE_DATA_SIZE];
+
+	gpointer user_data;
+
+	/* only set for synchronously emulated requests */
+	BraseroScsiResult result;
+	BraseroScsiErrCode code;
 };
+typedef struct _BraseroSgRequest BraseroSgRequest;
 
 struct _BraseroScsiCmd {
 	uchar cmd [BRASERO_SCSI_CMD_MAX_LEN];
@@ -68,6 +98,10 @@ typedef struct _BraseroScsiCmd BraseroScsiCmd;
 
 #define OPEN_FLAGS			O_RDWR /*|O_EXCL */|O_NONBLOCK
 
+#ifndef SCSI_GENERIC_MAJOR
+#define SCSI_GENERIC_MAJOR		21
+#endif
+
 /**
  * This is to send a command
  */
@@ -99,6 +133,20 @@ brasero_sg_command_setup (struct sg_io_hdr *transport,
 		transport->dxfer_direction = SG_DXFER_TO_DEV;
 }
 
+static BraseroScsiResult
+brasero_sg_command_status (struct sg_io_hdr *transport,
+			   uchar *sense_buffer,
+			   BraseroScsiErrCode *error)
+{
+	if ((transport->info & SG_INFO_OK_MASK) == SG_INFO_OK)
+		return BRASERO_SCSI_OK;
+
+	if ((transport->masked_status & CHECK_CONDITION) && transport->sb_len_wr)
+		return brasero_sense_data_process (sense_buffer, error);
+
+	return BRASERO_SCSI_FAILURE;
+}
+
 BraseroScsiResult
 brasero_scsi_command_issue_sync (gpointer command,
 				 gpointer buffer,
@@ -107,7 +155,7 @@ brasero_scsi_command_issue_sync (gpointer command,
 {
 	uchar sense_buffer [BRASERO_SENSE_DATA_SIZE];
 	struct sg_io_hdr transport;
-	BraseroScsiResult res;
+	int res;
 	BraseroScsiCmd *cmd;
 
 	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
@@ -127,13 +175,244 @@ brasero_scsi_command_issue_sync (gpointer command,
 		return BRASERO_SCSI_FAILURE;
 	}
 
-	if ((transport.info & SG_INFO_OK_MASK) == SG_INFO_OK)
+	return brasero_sg_command_status (&transport, sense_buffer, error);
+}
+
+/**
+ * This is to queue commands (several can be in flight on the same handle)
+ */
+
+static int
+brasero_sg_open_generic (BraseroDeviceHandle *handle)
+{
+	const gchar *name;
+	gchar *sysfs;
+	gchar *path;
+	struct stat buf;
+	GDir *dir;
+	int fd;
+
+	if (fstat (handle->fd, &buf))
+		return -1;
+
+	if (S_ISCHR (buf.st_mode) && major (buf.st_rdev) == SCSI_GENERIC_MAJOR)
+		return handle->fd;
+
+	if (!S_ISBLK (buf.st_mode))
+		return -1;
+
+	/* Find the sg node associated with this block device */
+	sysfs = g_strdup_printf ("/sys/dev/block/%u:%u/device/scsi_generic",
+				 major (buf.st_rdev),
+				 minor (buf.st_rdev));
+	dir = g_dir_open (sysfs, 0, NULL);
+	g_free (sysfs);
+
+	if (!dir)
+		return -1;
+
+	name = g_dir_read_name (dir);
+	if (!name) {
+		g_dir_close (dir);
+		return -1;
+	}
+
+	path = g_build_filename ("/dev", name, NULL);
+	g_dir_close (dir);
+
+	fd = open (path, OPEN_FLAGS);
+	if (fd < 0)
+		BRASERO_MEDIA_LOG ("Could not open %s for queued commands: %s",
+				   path,
+				   g_strerror (errno));
+	else
+		BRASERO_MEDIA_LOG ("Using %s for queued commands", path);
+
+	g_free (path);
+	return fd;
+}
+
+BraseroScsiResult
+brasero_scsi_command_issue_async (gpointer command,
+				  gpointer buffer,
+				  int size,
+				  gpointer user_data,
+				  BraseroScsiErrCode *error)
+{
+	BraseroDeviceHandle *handle;
+	BraseroSgRequest *request;
+	BraseroScsiCmd *cmd;
+
+	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
+
+	cmd = command;
+	handle = cmd->handle;
+
+	if (handle->async_fd == -2)
+		handle->async_fd = brasero_sg_open_generic (handle);
+
+	request = g_new0 (BraseroSgRequest, 1);
+	request->user_data = user_data;
+
+	if (handle->async_fd < 0) {
+		/* No way to queue it; run it now and queue its completion */
+		request->result = brasero_scsi_command_issue_sync (cmd,
+								   buffer,
+								   size,
+								   &request->code);
+		g_queue_push_tail (handle->completed, request);
+		handle->pending ++;
 		return BRASERO_SCSI_OK;
+	}
 
-	if ((transport.masked_status & CHECK_CONDITION) && transport.sb_len_wr)
-		return brasero_sense_data_process (sense_buffer, error);
+	memcpy (request->cmd, cmd->cmd, BRASERO_SCSI_CMD_MAX_LEN);
+	brasero_sg_command_setup (&request->transport,
+				  request->sense_buffer,
+				  cmd,
+				  buffer,
+				  size);
+	request->transport.cmdp = request->cmd;
+	request->transport.usr_ptr = request;
+	request->transport.pack_id = ++ handle->pack_id;
 
-	return BRASERO_SCSI_FAILURE;
+	if (write (handle->async_fd, &request->transport, sizeof (struct sg_io_hdr)) < 0) {
+		int errsv = errno;
+
+		g_free (request);
+
+		/* EDOM means the queue of the sg driver is full */
+		if (errsv == EDOM || errsv == EAGAIN)
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_NOT_READY);
+		else
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+
+		errno = errsv;
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	handle->in_flight = g_list_prepend (handle->in_flight, request);
+	handle->pending ++;
+	return BRASERO_SCSI_OK;
+}
+
+/* Called when async_fd can't be used any more: the requests still queued in
+ * the driver are given up and async_fd is not used for new commands. Their
+ * buffers can be freed since the sg driver only copies data to them when a
+ * request is read back (we don't use direct IO). */
+static void
+brasero_sg_drop_requests (BraseroDeviceHandle *handle)
+{
+	BraseroSgRequest *request;
+
+	if (handle->in_flight)
+		BRASERO_MEDIA_LOG ("%i queued commands lost", g_list_length (handle->in_flight));
+
+	g_list_foreach (handle->in_flight, (GFunc) g_free, NULL);
+	g_list_free (handle->in_flight);
+	handle->in_flight = NULL;
+
+	while ((request = g_queue_pop_head (handle->completed)))
+		g_free (request);
+
+	handle->pending = 0;
+
+	if (handle->async_fd >= 0 && handle->async_fd != handle->fd)
+		close (handle->async_fd);
+
+	handle->async_fd = -1;
+}
+
+int
+brasero_device_handle_get_pending (BraseroDeviceHandle *handle)
+{
+	g_return_val_if_fail (handle != NULL, 0);
+	return handle->pending;
+}
+
+BraseroScsiResult
+brasero_device_handle_wait_completion (BraseroDeviceHandle *handle,
+				       gpointer *user_data,
+				       BraseroScsiErrCode *error)
+{
+	struct sg_io_hdr transport;
+	BraseroSgRequest *request;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	if (!handle->pending) {
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	request = g_queue_pop_head (handle->completed);
+	if (request) {
+		handle->pending --;
+
+		if (user_data)
+			*user_data = request->user_data;
+
+		res = request->result;
+		if (res != BRASERO_SCSI_OK)
+			BRASERO_SCSI_SET_ERRCODE (error, request->code);
+
+		g_free (request);
+		return res;
+	}
+
+	while (1) {
+		struct pollfd fd;
+
+		memset (&transport, 0, sizeof (struct sg_io_hdr));
+		transport.interface_id = 'S';
+		transport.pack_id = -1;
+
+		if (read (handle->async_fd, &transport, sizeof (struct sg_io_hdr)) >= 0)
+			break;
+
+		if (errno != EAGAIN && errno != EINTR) {
+			/* The descriptor is unusable so there is no way to
+			 * know what happened to the remaining commands */
+			BRASERO_MEDIA_LOG ("Queued commands lost: %s", g_strerror (errno));
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+			brasero_sg_drop_requests (handle);
+			return BRASERO_SCSI_FAILURE;
+		}
+
+		/* nothing finished yet: wait for it */
+		fd.fd = handle->async_fd;
+		fd.events = POLLIN;
+		fd.revents = 0;
+		if (poll (&fd, 1, -1) < 0 && errno != EINTR) {
+			BRASERO_MEDIA_LOG ("Queued commands lost: %s", g_strerror (errno));
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+			brasero_sg_drop_requests (handle);
+			return BRASERO_SCSI_FAILURE;
+		}
+	}
+
+	handle->pending --;
+
+	request = transport.usr_ptr;
+	handle->in_flight = g_list_remove (handle->in_flight, request);
+
+	if (user_data)
+		*user_data = request->user_data;
+
+	res = brasero_sg_command_status (&transport, request->sense_buffer, error);
+
+	/* A read that returned less than asked would leave garbage in the
+	 * buffer of the caller */
+	if (res == BRASERO_SCSI_OK
+	&&  transport.dxfer_direction == SG_DXFER_FROM_DEV
+	&&  transport.resid) {
+		BRASERO_MEDIA_LOG ("Short transfer (%i bytes missing)", transport.resid);
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_SIZE_MISMATCH);
+		res = BRASERO_SCSI_FAILURE;
+	}
+
+	g_free (request);
+	return res;
 }
 
 gpointer
@@ -194,8 +473,10 @@ brasero_device_handle_open (const gchar *path,
 		return NULL;
 	}
 
-	handle = g_new (BraseroDeviceHandle, 1);
+	handle = g_new0 (BraseroDeviceHandle, 1);
 	handle->fd = fd;
+	handle->async_fd = -2;
+	handle->completed = g_queue_new ();
 
 	BRASERO_MEDIA_LOG ("Handle ready");
 	return handle;
@@ -204,10 +485,100 @@ brasero_device_handle_open (const gchar *path,
 void
 brasero_device_handle_close (BraseroDeviceHandle *handle)
 {
+	/* Reap all queued commands so none outlives the handle. If async_fd
+	 * fails meanwhile, the remaining ones are dropped. */
+	while (handle->pending)
+		brasero_device_handle_wait_completion (handle, NULL, NULL);
+
+	brasero_sg_drop_requests (handle);
+	g_queue_free (handle->completed);
+
 	close (handle->fd);
 	g_free (handle);
 }
 
+static int
+brasero_device_handle_get_max_sectors_kb (struct stat *buf)
+{
+	gchar *contents = NULL;
+	gchar *path = NULL;
+	int max_kb = 0;
+
+	if (S_ISBLK (buf->st_mode))
+		path = g_strdup_printf ("/sys/dev/block/%u:%u/queue/max_sectors_kb",
+					major (buf->st_rdev),
+					minor (buf->st_rdev));
+	else if (S_ISCHR (buf->st_mode)) {
+		const gchar *name;
+		gchar *sysfs;
+		GDir *dir;
+
+		/* sg node: find the associated block device */
+		sysfs = g_strdup_printf ("/sys/dev/char/%u:%u/device/block",
+					 major (buf->st_rdev),
+					 minor (buf->st_rdev));
+		dir = g_dir_open (sysfs, 0, NULL);
+		if (dir) {
+			name = g_dir_read_name (dir);
+			if (name)
+				path = g_build_filename (sysfs,
+							 name,
+							 "queue",
+							 "max_sectors_kb",
+							 NULL);
+			g_dir_close (dir);
+		}
+		g_free (sysfs);
+	}
+
+	if (!path)
+		return 0;
+
+	if (g_file_get_contents (path, &contents, NULL, NULL)) {
+		max_kb = atoi (contents);
+		g_free (contents);
+	}
+
+	g_free (path);
+	return max_kb;
+}
+
+/**
+ * Returns the maximum number of bytes a single command can transfer or 0 if
+ * it is unknown.
+ */
+
+int
+brasero_device_handle_get_max_transfer (BraseroDeviceHandle *handle)
+{
+	struct stat buf;
+	int reserved = 0;
+	int max = 0;
+
+	g_return_val_if_fail (handle != NULL, 0);
+
+	if (fstat (handle->fd, &buf))
+		return 0;
+
+	/* limit of the block layer for this device */
+	max = brasero_device_handle_get_max_sectors_kb (&buf) * 1024;
+
+	/* On block devices this is the size the block layer reserves for SG_IO
+	 * (capped by the queue limits). On sg nodes it is only the size of the
+	 * preallocated buffer and bigger transfers still work so it's only used
+	 * if there is nothing better. */
+	if (ioctl (handle->fd, SG_GET_RESERVED_SIZE, &reserved) < 0)
+		reserved = 0;
+
+	if (reserved > 0 && (max <= 0 || (S_ISBLK (buf.st_mode) && reserved < max)))
+		max = reserved;
+
+	BRASERO_MEDIA_LOG ("Maximum transfer length %i bytes (reserved size %i)",
+			   max,
+			   reserved);
+	return MAX (max, 0);
+}
+
 char *
 brasero_device_get_bus_target_lun (const gchar *device)
 {
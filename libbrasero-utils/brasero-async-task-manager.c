@@ -53,6 +53,7 @@ struct BraseroAsyncTaskManagerPrivate {
 
 	gint num_threads;
 	gint unused_threads;
+	gint max_threads;
 
 	gint cancelled:1;
 };
@@ -115,6 +116,7 @@ brasero_async_task_manager_init (BraseroAsyncTaskManager *obj)
 	obj->priv->new_task = g_cond_new ();
 
 	obj->priv->lock = g_mutex_new ();
+	obj->priv->max_threads = MANAGER_MAX_THREAD;
 }
 
 static void
@@ -312,6 +314,20 @@ end:
 	return NULL;
 }
 
+void
+brasero_async_task_manager_set_max_threads (BraseroAsyncTaskManager *self,
+					    guint max_threads)
+{
+	g_return_if_fail (BRASERO_IS_ASYNC_TASK_MANAGER (self));
+	g_return_if_fail (max_threads > 0);
+
+	/* NOTE: if there are more threads running they will exit on their own
+	 * after a while when they are unused */
+	g_mutex_lock (self->priv->lock);
+	self->priv->max_threads = max_threads;
+	g_mutex_unlock (self->priv->lock);
+}
+
 gboolean
 brasero_async_task_manager_queue (BraseroAsyncTaskManager *self,
 				  BraseroAsyncPriority priority,
@@ -339,7 +355,7 @@ brasero_async_task_manager_queue (BraseroAsyncTaskManager *self,
 		/* wake up one thread in the list */
 		g_cond_signal (self->priv->new_task);
 	}
-	else if (self->priv->num_threads < MANAGER_MAX_THREAD) {
+	else if (self->priv->num_threads < self->priv->max_threads) {
 		GError *error = NULL;
 		GThread *thread;
 
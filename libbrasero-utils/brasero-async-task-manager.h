@@ -90,6 +90,10 @@ typedef enum {
 	BRASERO_ASYNC_URGENT		= 1 << 3
 } BraseroAsyncPriority;
 
+void
+brasero_async_task_manager_set_max_threads (BraseroAsyncTaskManager *manager,
+					    guint max_threads);
+
 gboolean
 brasero_async_task_manager_queue (BraseroAsyncTaskManager *manager,
 				  BraseroAsyncPriority priority,
@@ -34,6 +34,13 @@
 
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <glib.h>
 #include <glib-object.h>
@@ -85,12 +92,15 @@ struct _BraseroIOPrivate
 	GSList *mounted;
 
 	/* used for returning results */
-	GSList *results;
+	GQueue results;
 	gint results_id;
 
 	/* used for metadata */
 	GMutex *lock_metadata;
 
+	/* signalled when a metadata object is put back in metadatas */
+	GCond *metadata_available;
+
 	GSList *metadatas;
 	GSList *metadata_running;
 
@@ -113,6 +123,10 @@ struct _BraseroIOPrivate
 #define MAX_CONCURENT_META 	2
 #define MAX_BUFFERED_META	20
 
+/* Loading directories is mostly waiting for the disk so a few more threads
+ * than metadata objects allow to load several directories in parallel. */
+#define MAX_THREADS		4
+
 struct _BraseroIOJobResult {
 	const BraseroIOJobBase *base;
 	BraseroIOResultCallbackData *callback_data;
@@ -340,13 +354,13 @@ brasero_io_return_result_idle (gpointer callback_data)
 
 	/* Return several results at a time that can be a huge speed gain.
 	 * What should be the value that provides speed and responsiveness? */
-	for (i = 0; priv->results && i < NUMBER_OF_RESULTS;) {
+	for (i = 0; priv->results.head && i < NUMBER_OF_RESULTS;) {
 		BraseroIOJobBase *base;
-		GSList *iter;
+		GList *iter;
 
 		/* Find the next result that can be returned */
 		result = NULL;
-		for (iter = priv->results; iter; iter = iter->next) {
+		for (iter = priv->results.head; iter; iter = iter->next) {
 			BraseroIOJobResult *tmp_result;
 
 			tmp_result = iter->data;
@@ -366,7 +380,7 @@ brasero_io_return_result_idle (gpointer callback_data)
 		base = (BraseroIOJobBase *) result->base;
 		base->methods->in_use = TRUE;
 
-		priv->results = g_slist_remove (priv->results, result);
+		g_queue_delete_link (&priv->results, iter);
 
 		/* This is to make sure the object
 		 *  lives as long as we need it. */
@@ -399,7 +413,7 @@ brasero_io_return_result_idle (gpointer callback_data)
 		base->methods->in_use = FALSE;
 	}
 
-	if (!priv->results_id && priv->results && i >= NUMBER_OF_RESULTS) {
+	if (!priv->results_id && priv->results.head && i >= NUMBER_OF_RESULTS) {
 		/* There are still results and no idle call is scheduled so we
 		 * have to restart ourselves to make sure we empty the queue */
 		priv->results_id = results_id;
@@ -421,20 +435,45 @@ brasero_io_queue_result (BraseroIO *self,
 
 	/* insert the task in the results queue */
 	g_mutex_lock (priv->lock);
-	priv->results = g_slist_append (priv->results, result);
+	g_queue_push_tail (&priv->results, result);
 	if (!priv->results_id)
 		priv->results_id = g_idle_add ((GSourceFunc) brasero_io_return_result_idle, self);
 	g_mutex_unlock (priv->lock);
 }
 
-void
-brasero_io_return_result (const BraseroIOJobBase *base,
-			  const gchar *uri,
-			  GFileInfo *info,
-			  GError *error,
-			  BraseroIOResultCallbackData *callback_data)
+/**
+ * Queue all the results of a batch at once (the batch is emptied) so that
+ * threads returning a lot of results don't fight over the lock for each.
+ */
+
+static void
+brasero_io_queue_results (BraseroIO *self,
+			  GQueue *batch)
+{
+	BraseroIOPrivate *priv;
+	BraseroIOJobResult *result;
+
+	if (g_queue_is_empty (batch))
+		return;
+
+	priv = BRASERO_IO_PRIVATE (self);
+
+	g_mutex_lock (priv->lock);
+	while ((result = g_queue_pop_head (batch)))
+		g_queue_push_tail (&priv->results, result);
+
+	if (!priv->results_id)
+		priv->results_id = g_idle_add ((GSourceFunc) brasero_io_return_result_idle, self);
+	g_mutex_unlock (priv->lock);
+}
+
+static BraseroIOJobResult *
+brasero_io_job_result_new (const BraseroIOJobBase *base,
+			   const gchar *uri,
+			   GFileInfo *info,
+			   GError *error,
+			   BraseroIOResultCallbackData *callback_data)
 {
-	BraseroIO *self = brasero_io_get_default ();
 	BraseroIOJobResult *result;
 
 	/* even if it is cancelled we let the result go through to be able to 
@@ -451,6 +490,24 @@ brasero_io_return_result (const BraseroIOJobBase *base,
 		result->callback_data = callback_data;
 	}
 
+	return result;
+}
+
+void
+brasero_io_return_result (const BraseroIOJobBase *base,
+			  const gchar *uri,
+			  GFileInfo *info,
+			  GError *error,
+			  BraseroIOResultCallbackData *callback_data)
+{
+	BraseroIO *self = brasero_io_get_default ();
+	BraseroIOJobResult *result;
+
+	result = brasero_io_job_result_new (base,
+					    uri,
+					    info,
+					    error,
+					    callback_data);
 	brasero_io_queue_result (self, result);
 	g_object_unref (self);
 }
@@ -924,15 +981,21 @@ brasero_io_find_metadata (BraseroIO *self,
 		}
 	}
 
-	/* Grab an available metadata (NOTE: there should always be at least one
-	 * since we run 2 threads at max and have two metadatas available) */
+	/* Grab an available metadata (NOTE: there may be none available since
+	 * there can be more threads than metadatas; then wait for one to be
+	 * returned; wake up from time to time to check for cancellation) */
 	while (!priv->metadatas) {
+		GTimeVal wait_time;
+
 		if (g_cancellable_is_cancelled (cancel))
 			return NULL;
 
-		g_mutex_unlock (priv->lock_metadata);
-		g_usleep (250);
-		g_mutex_lock (priv->lock_metadata);
+		g_get_current_time (&wait_time);
+		g_time_val_add (&wait_time, 100000);
+
+		g_cond_timed_wait (priv->metadata_available,
+				   priv->lock_metadata,
+				   &wait_time);
 	}
 
 	/* One metadata is finally available */
@@ -1008,6 +1071,7 @@ brasero_io_wait_for_metadata (BraseroIO *self,
 
 	priv->metadata_running = g_slist_remove (priv->metadata_running, metadata);
 	priv->metadatas = g_slist_append (priv->metadatas, metadata);
+	g_cond_signal (priv->metadata_available);
 
 	g_mutex_unlock (priv->lock_metadata);
 
@@ -1968,177 +2032,343 @@ brasero_io_load_directory_playlist (BraseroIO *self,
 
 #endif
 
-static BraseroAsyncTaskResult
-brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
-				  GCancellable *cancel,
-				  gpointer callback_data)
-{
-	gchar attributes [512] = {G_FILE_ATTRIBUTE_STANDARD_NAME "," 
-				  G_FILE_ATTRIBUTE_STANDARD_SIZE ","
-				  G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK ","
-				  G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET ","
-				  G_FILE_ATTRIBUTE_STANDARD_TYPE };
-	BraseroIOContentsData *data = callback_data;
-	GFileEnumerator *enumerator;
-	GError *error = NULL;
-	GFileInfo *info;
-	GFile *file;
+/**
+ * Results are returned by batches of that size while loading directories
+ */
 
-	if (data->job.options & BRASERO_IO_INFO_PERM)
-		strcat (attributes, "," G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
+#define BRASERO_IO_RESULTS_BATCH	256
 
-	if (data->job.options & BRASERO_IO_INFO_MIME)
-		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
-	else if ((data->job.options & BRASERO_IO_INFO_METADATA)
-	     &&  (data->job.options & BRASERO_IO_INFO_RECURSIVE))
-		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
+static void
+brasero_io_load_directory_child (BraseroIO *self,
+				 GCancellable *cancel,
+				 BraseroIOContentsData *data,
+				 GFile *file,
+				 GFileInfo *info,
+				 const gchar *attributes,
+				 GQueue *batch)
+{
+	const gchar *name;
+	gchar *child_uri;
+	GFile *child;
+
+	name = g_file_info_get_name (info);
+	if (name [0] == '.'
+	&& (name [1] == '\0'
+	|| (name [1] == '.' && name [2] == '\0'))) {
+		g_object_unref (info);
+		return;
+	}
 
-	if (data->job.options & BRASERO_IO_INFO_ICON)
-		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_ICON);
+	child = g_file_get_child (file, name);
+	if (!child) {
+		g_object_unref (info);
+		return;
+	}
 
-	if (data->children) {
-		file = data->children->data;
-		data->children = g_slist_remove (data->children, file);
+	child_uri = g_file_get_uri (child);
+
+	/* special case for symlinks */
+	if (g_file_info_get_is_symlink (info)) {
+		if (!brasero_io_check_symlink_target (file, info)) {
+			GError *error;
+
+			error = g_error_new (BRASERO_UTILS_ERROR,
+					     BRASERO_UTILS_ERROR_SYMLINK_LOOP,
+					     _("Recursive symbolic link"));
+
+			/* since we checked for the existence of the file
+			 * an error means a looping symbolic link */
+			g_queue_push_tail (batch,
+					   brasero_io_job_result_new (data->job.base,
+								      child_uri,
+								      NULL,
+								      error,
+								      data->job.callback_data));
+
+			g_free (child_uri);
+			g_object_unref (info);
+			g_object_unref (child);
+			return;
+		}
 	}
-	else
-		file = g_file_new_for_uri (data->job.uri);
 
-	enumerator = g_file_enumerate_children (file,
-						attributes,
-						(data->job.options & BRASERO_IO_INFO_FOLLOW_SYMLINK)?G_FILE_QUERY_INFO_NONE:G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,	/* follow symlinks by default*/
-						cancel,
-						&error);
+	if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) {
+		g_queue_push_tail (batch,
+				   brasero_io_job_result_new (data->job.base,
+							      child_uri,
+							      info,
+							      NULL,
+							      data->job.callback_data));
 
-	if (!enumerator) {
-		gchar *directory_uri;
+		if (data->job.options & BRASERO_IO_INFO_RECURSIVE)
+			data->children = g_slist_prepend (data->children, child);
+		else
+			g_object_unref (child);
 
-		directory_uri = g_file_get_uri (file);
-		brasero_io_return_result (data->job.base,
-					  directory_uri,
-					  NULL,
-					  error,
-					  data->job.callback_data);
-		g_free (directory_uri);
-		g_object_unref (file);
+		g_free (child_uri);
+		return;
+	}
 
-		if (data->children)
-			return BRASERO_ASYNC_TASK_RESCHEDULE;
+	if (data->job.options & BRASERO_IO_INFO_METADATA) {
+		BraseroMetadataInfo metadata = {NULL, };
+		gboolean result;
 
-		return BRASERO_ASYNC_TASK_FINISHED;
+		/* add metadata information to this file */
+		result = brasero_io_get_metadata_info (self,
+						       cancel,
+						       child_uri,
+						       info,
+						       ((data->job.options & BRASERO_IO_INFO_METADATA_MISSING_CODEC) ? BRASERO_METADATA_FLAG_MISSING : 0) |
+						       ((data->job.options & BRASERO_IO_INFO_METADATA_THUMBNAIL) ? BRASERO_METADATA_FLAG_THUMBNAIL : 0),
+						       &metadata);
+
+		if (result)
+			brasero_io_set_metadata_attributes (info, &metadata);
+
+#ifdef BUILD_PLAYLIST
+
+		else if (data->job.options & BRASERO_IO_INFO_RECURSIVE) {
+			const gchar *mime;
+
+			mime = g_file_info_get_content_type (info);
+			if (mime
+			&& (!strcmp (mime, "audio/x-scpls")
+			||  !strcmp (mime, "audio/x-ms-asx")
+			||  !strcmp (mime, "audio/x-mp3-playlist")
+			||  !strcmp (mime, "audio/x-mpegurl")))
+				brasero_io_load_directory_playlist (self,
+								    cancel,
+								    data,
+								    child_uri,
+								    attributes);
+		}
+
+#endif
+
+		brasero_metadata_info_clear (&metadata);
 	}
 
-	while ((info = g_file_enumerator_next_file (enumerator, cancel, NULL))) {
+	g_queue_push_tail (batch,
+			   brasero_io_job_result_new (data->job.base,
+						      child_uri,
+						      info,
+						      NULL,
+						      data->job.callback_data));
+	g_free (child_uri);
+	g_object_unref (child);
+}
+
+/**
+ * Fast path for local directories when neither mime types nor metadata are
+ * required (that's the case when loading a data project): the directory is
+ * read directly and only what is needed is stat'ed, relative to the directory
+ * file descriptor. That saves GIO the lookup of a lot of attributes and the
+ * conversion of paths for every child.
+ * Returns FALSE if the directory could not be opened; GIO is then used to get
+ * a proper error.
+ */
+
+static gboolean
+brasero_io_load_directory_local (BraseroIO *self,
+				 GCancellable *cancel,
+				 BraseroIOContentsData *data,
+				 GFile *file,
+				 const gchar *attributes,
+				 GQueue *batch)
+{
+	struct dirent *entry;
+	gboolean follow;
+	gchar *path;
+	int dir_fd;
+	DIR *dir;
+
+	path = g_file_get_path (file);
+	if (!path)
+		return FALSE;
+
+	dir = opendir (path);
+	g_free (path);
+
+	if (!dir)
+		return FALSE;
+
+	dir_fd = dirfd (dir);
+	follow = (data->job.options & BRASERO_IO_INFO_FOLLOW_SYMLINK) != 0;
+
+	/* NOTE: readdir () reads the entries by big chunks (getdents) */
+	while ((entry = readdir (dir))) {
 		const gchar *name;
-		gchar *child_uri;
-		GFile *child;
+		GFileInfo *info;
+		struct stat st;
 
-		name = g_file_info_get_name (info);
-		if (g_cancellable_is_cancelled (cancel)) {
-			g_object_unref (info);
+		if (g_cancellable_is_cancelled (cancel))
 			break;
-		}
 
+		name = entry->d_name;
 		if (name [0] == '.'
 		&& (name [1] == '\0'
-		|| (name [1] == '.' && name [2] == '\0'))) {
-			g_object_unref (info);
+		|| (name [1] == '.' && name [2] == '\0')))
 			continue;
-		}
 
-		child = g_file_get_child (file, name);
-		if (!child)
+		if (fstatat (dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) == -1)
 			continue;
 
-		child_uri = g_file_get_uri (child);
+		info = g_file_info_new ();
+		g_file_info_set_name (info, name);
 
-		/* special case for symlinks */
-		if (g_file_info_get_is_symlink (info)) {
-			if (!brasero_io_check_symlink_target (file, info)) {
-				error = g_error_new (BRASERO_UTILS_ERROR,
-						     BRASERO_UTILS_ERROR_SYMLINK_LOOP,
-						     _("Recursive symbolic link"));
-
-				/* since we checked for the existence of the file
-				 * an error means a looping symbolic link */
-				brasero_io_return_result (data->job.base,
-							  child_uri,
-							  NULL,
-							  error,
-							  data->job.callback_data);
+		if (S_ISLNK (st.st_mode)) {
+			gchar target [PATH_MAX];
+			struct stat target_st;
+			ssize_t len;
+
+			g_file_info_set_is_symlink (info, TRUE);
 
-				g_free (child_uri);
-				g_object_unref (info);
-				g_object_unref (child);
-				continue;
+			len = readlinkat (dir_fd, name, target, sizeof (target) - 1);
+			if (len > 0) {
+				target [len] = '\0';
+				g_file_info_set_symlink_target (info, target);
 			}
+
+			/* Like GIO, keep the link itself if the target is
+			 * missing */
+			if (follow && fstatat (dir_fd, name, &target_st, 0) == 0)
+				st = target_st;
 		}
 
-		if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) {
-			brasero_io_return_result (data->job.base,
-						  child_uri,
-						  info,
-						  NULL,
-						  data->job.callback_data);
+		if (S_ISDIR (st.st_mode))
+			g_file_info_set_file_type (info, G_FILE_TYPE_DIRECTORY);
+		else if (S_ISREG (st.st_mode))
+			g_file_info_set_file_type (info, G_FILE_TYPE_REGULAR);
+		else if (S_ISLNK (st.st_mode))
+			g_file_info_set_file_type (info, G_FILE_TYPE_SYMBOLIC_LINK);
+		else
+			g_file_info_set_file_type (info, G_FILE_TYPE_SPECIAL);
 
-			if (data->job.options & BRASERO_IO_INFO_RECURSIVE)
-				data->children = g_slist_prepend (data->children, child);
-			else
-				g_object_unref (child);
+		g_file_info_set_size (info, st.st_size);
 
-			g_free (child_uri);
-			continue;
-		}
+		if (data->job.options & BRASERO_IO_INFO_PERM)
+			g_file_info_set_attribute_boolean (info,
+							   G_FILE_ATTRIBUTE_ACCESS_CAN_READ,
+							   faccessat (dir_fd, name, R_OK, 0) == 0);
 
-		if (data->job.options & BRASERO_IO_INFO_METADATA) {
-			BraseroMetadataInfo metadata = {NULL, };
-			gboolean result;
+		brasero_io_load_directory_child (self,
+						 cancel,
+						 data,
+						 file,
+						 info,
+						 attributes,
+						 batch);
 
-			/* add metadata information to this file */
-			result = brasero_io_get_metadata_info (BRASERO_IO (manager),
-							       cancel,
-							       child_uri,
-							       info,
-							       ((data->job.options & BRASERO_IO_INFO_METADATA_MISSING_CODEC) ? BRASERO_METADATA_FLAG_MISSING : 0) |
-							       ((data->job.options & BRASERO_IO_INFO_METADATA_THUMBNAIL) ? BRASERO_METADATA_FLAG_THUMBNAIL : 0),
-							       &metadata);
+		if (g_queue_get_length (batch) >= BRASERO_IO_RESULTS_BATCH)
+			brasero_io_queue_results (self, batch);
+	}
 
-			if (result)
-				brasero_io_set_metadata_attributes (info, &metadata);
+	closedir (dir);
+	return TRUE;
+}
 
-#ifdef BUILD_PLAYLIST
+static void
+brasero_io_load_directory_gio (BraseroIO *self,
+			       GCancellable *cancel,
+			       BraseroIOContentsData *data,
+			       GFile *file,
+			       const gchar *attributes,
+			       GQueue *batch)
+{
+	GFileEnumerator *enumerator;
+	GError *error = NULL;
+	GFileInfo *info;
 
-			else if (data->job.options & BRASERO_IO_INFO_RECURSIVE) {
-				const gchar *mime;
-
-				mime = g_file_info_get_content_type (info);
-				if (mime
-				&& (!strcmp (mime, "audio/x-scpls")
-				||  !strcmp (mime, "audio/x-ms-asx")
-				||  !strcmp (mime, "audio/x-mp3-playlist")
-				||  !strcmp (mime, "audio/x-mpegurl")))
-					brasero_io_load_directory_playlist (BRASERO_IO (manager),
-									    cancel,
-									    data,
-									    child_uri,
-									    attributes);
-			}
+	enumerator = g_file_enumerate_children (file,
+						attributes,
+						(data->job.options & BRASERO_IO_INFO_FOLLOW_SYMLINK)?G_FILE_QUERY_INFO_NONE:G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,	/* follow symlinks by default*/
+						cancel,
+						&error);
 
-#endif
+	if (!enumerator) {
+		gchar *directory_uri;
+
+		directory_uri = g_file_get_uri (file);
+		g_queue_push_tail (batch,
+				   brasero_io_job_result_new (data->job.base,
+							      directory_uri,
+							      NULL,
+							      error,
+							      data->job.callback_data));
+		g_free (directory_uri);
+		return;
+	}
 
-			brasero_metadata_info_clear (&metadata);
+	while ((info = g_file_enumerator_next_file (enumerator, cancel, NULL))) {
+		if (g_cancellable_is_cancelled (cancel)) {
+			g_object_unref (info);
+			break;
 		}
 
-		brasero_io_return_result (data->job.base,
-					  child_uri,
-					  info,
-					  NULL,
-					  data->job.callback_data);
-		g_free (child_uri);
-		g_object_unref (child);
+		brasero_io_load_directory_child (self,
+						 cancel,
+						 data,
+						 file,
+						 info,
+						 attributes,
+						 batch);
+
+		if (g_queue_get_length (batch) >= BRASERO_IO_RESULTS_BATCH)
+			brasero_io_queue_results (self, batch);
 	}
 
 	g_file_enumerator_close (enumerator, NULL, NULL);
 	g_object_unref (enumerator);
+}
+
+static BraseroAsyncTaskResult
+brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
+				  GCancellable *cancel,
+				  gpointer callback_data)
+{
+	gchar attributes [512] = {G_FILE_ATTRIBUTE_STANDARD_NAME "," 
+				  G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+				  G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK ","
+				  G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET ","
+				  G_FILE_ATTRIBUTE_STANDARD_TYPE };
+	BraseroIOContentsData *data = callback_data;
+	GQueue batch = G_QUEUE_INIT;
+	GFile *file;
+
+	if (data->job.options & BRASERO_IO_INFO_PERM)
+		strcat (attributes, "," G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
+
+	if (data->job.options & BRASERO_IO_INFO_MIME)
+		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
+	else if ((data->job.options & BRASERO_IO_INFO_METADATA)
+	     &&  (data->job.options & BRASERO_IO_INFO_RECURSIVE))
+		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
+
+	if (data->job.options & BRASERO_IO_INFO_ICON)
+		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_ICON);
+
+	if (data->children) {
+		file = data->children->data;
+		data->children = g_slist_remove (data->children, file);
+	}
+	else
+		file = g_file_new_for_uri (data->job.uri);
+
+	if ((data->job.options & (BRASERO_IO_INFO_MIME|BRASERO_IO_INFO_ICON|BRASERO_IO_INFO_METADATA))
+	||  !brasero_io_load_directory_local (BRASERO_IO (manager),
+					      cancel,
+					      data,
+					      file,
+					      attributes,
+					      &batch))
+		brasero_io_load_directory_gio (BRASERO_IO (manager),
+					       cancel,
+					       data,
+					       file,
+					       attributes,
+					       &batch);
+
+	brasero_io_queue_results (BRASERO_IO (manager), &batch);
 	g_object_unref (file);
 
 	if (data->children)
@@ -2188,7 +2418,7 @@ brasero_io_cancel_result (BraseroIO *self,
 	priv = BRASERO_IO_PRIVATE (self);
 
 	g_mutex_lock (priv->lock);
-	priv->results = g_slist_remove (priv->results, result);
+	g_queue_remove (&priv->results, result);
 	g_mutex_unlock (priv->lock);
 
 	data = result->callback_data;
@@ -2216,8 +2446,8 @@ brasero_io_cancel_tasks_by_base_cb (BraseroAsyncTaskManager *manager,
 void
 brasero_io_cancel_by_base (BraseroIOJobBase *base)
 {
-	GSList *iter;
-	GSList *next;
+	GList *iter;
+	GList *next;
 	BraseroIOPrivate *priv;
 	BraseroIO *self = brasero_io_get_default ();
 
@@ -2232,7 +2462,7 @@ brasero_io_cancel_by_base (BraseroIOJobBase *base)
 							  base);
 
 	/* do it afterwards in case some results slipped through */
-	for (iter = priv->results; iter; iter = next) {
+	for (iter = priv->results.head; iter; iter = next) {
 		BraseroIOJobResult *result;
 
 		result = iter->data;
@@ -2371,9 +2601,12 @@ brasero_io_init (BraseroIO *object)
 
 	priv->lock = g_mutex_new ();
 	priv->lock_metadata = g_mutex_new ();
+	priv->metadata_available = g_cond_new ();
 
 	priv->meta_buffer = g_queue_new ();
 
+	brasero_async_task_manager_set_max_threads (BRASERO_ASYNC_TASK_MANAGER (object), MAX_THREADS);
+
 	/* create metadatas now since it doesn't work well when it's created in 
 	 * a thread. */
 	metadata = brasero_metadata_new ();
@@ -2399,7 +2632,6 @@ static void
 brasero_io_finalize (GObject *object)
 {
 	BraseroIOPrivate *priv;
-	GSList *iter;
 
 	priv = BRASERO_IO_PRIVATE (object);
 
@@ -2430,14 +2662,8 @@ brasero_io_finalize (GObject *object)
 		priv->results_id = 0;
 	}
 
-	for (iter = priv->results; iter; iter = iter->next) {
-		BraseroIOJobResult *result;
-
-		result = iter->data;
-		brasero_io_job_result_free (result);
-	}
-	g_slist_free (priv->results);
-	priv->results = NULL;
+	g_queue_foreach (&priv->results, (GFunc) brasero_io_job_result_free, NULL);
+	g_queue_clear (&priv->results);
 
 	if (priv->progress_id) {
 		g_source_remove (priv->progress_id);
@@ -2460,6 +2686,11 @@ brasero_io_finalize (GObject *object)
 		priv->lock_metadata = NULL;
 	}
 
+	if (priv->metadata_available) {
+		g_cond_free (priv->metadata_available);
+		priv->metadata_available = NULL;
+	}
+
 	if (priv->mounted) {
 		GSList *iter;
 
@@ -2504,7 +2735,7 @@ brasero_io_cancel (BraseroAsyncTaskManager *manager,
 void
 brasero_io_shutdown (void)
 {
-	GSList *iter, *next;
+	GList *iter, *next;
 	BraseroIOPrivate *priv;
 
 	priv = BRASERO_IO_PRIVATE (singleton);
@@ -2518,7 +2749,7 @@ brasero_io_shutdown (void)
 							  NULL);
 
 	/* do it afterwards in case some results slipped through */
-	for (iter = priv->results; iter; iter = next) {
+	for (iter = priv->results.head; iter; iter = next) {
 		BraseroIOJobResult *result;
 
 		result = iter->data;
@@ -0,0 +1,538 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "burn-debug.h"
+#include "burn-checksum-cache.h"
+
+/**
+ * The cache is a file under the user cache directory holding an open
+ * addressing hash table. Entries are keyed by device, inode and checksum type
+ * and are only valid if the size and the modification time of the file are
+ * still the same.
+ * The table of the former runs is mapped read only; entries added or used
+ * during this run are kept in memory and a new table is written when the
+ * cache is closed. Each entry records when it was last used so that the
+ * least recently used entries are the ones dropped once the cache is full.
+ */
+
+#define BRASERO_CHECKSUM_CACHE_MAGIC		0x43534242	/* "BBSC" */
+#define BRASERO_CHECKSUM_CACHE_VERSION		2
+#define BRASERO_CHECKSUM_CACHE_MAX_ENTRIES	(512 * 1024)
+#define BRASERO_CHECKSUM_CACHE_DIGEST_MAX	32
+
+struct _BraseroChecksumCacheHeader {
+	guint32 magic;
+	guint32 version;
+
+	/* a power of 2 */
+	guint32 slots;
+	guint32 entries;
+};
+typedef struct _BraseroChecksumCacheHeader BraseroChecksumCacheHeader;
+
+struct _BraseroChecksumCacheEntry {
+	guint64 dev;
+	guint64 ino;
+	guint64 size;
+	guint64 mtime_ns;
+
+	/* GChecksumType + 1 so that 0 means an empty slot */
+	guint32 type;
+
+	/* seconds since the epoch when the entry was last inserted or found */
+	guint32 last_used;
+
+	guchar digest [BRASERO_CHECKSUM_CACHE_DIGEST_MAX];
+};
+typedef struct _BraseroChecksumCacheEntry BraseroChecksumCacheEntry;
+
+struct _BraseroChecksumCache {
+	gchar *path;
+
+	/* table written by former runs */
+	GMappedFile *mapped;
+	const BraseroChecksumCacheHeader *header;
+	BraseroChecksumCacheEntry *table;
+
+	/* entries added or found during this run; lookups and insertions
+	 * happen from several threads */
+	GMutex *lock;
+	GHashTable *added;
+
+	guint64 hits;
+	guint64 misses;
+};
+
+static guint64
+brasero_checksum_cache_hash_key (const BraseroChecksumCacheEntry *entry)
+{
+	guint64 hash;
+
+	hash = entry->ino * G_GUINT64_CONSTANT (0x9E3779B97F4A7C15);
+	hash ^= entry->dev + G_GUINT64_CONSTANT (0x632BE59BD9B4E019) + (hash << 6) + (hash >> 2);
+	hash ^= entry->type;
+	return hash;
+}
+
+static guint
+brasero_checksum_cache_entry_hash (gconstpointer data)
+{
+	guint64 hash;
+
+	hash = brasero_checksum_cache_hash_key (data);
+	return (guint) (hash ^ (hash >> 32));
+}
+
+static gboolean
+brasero_checksum_cache_entry_equal (gconstpointer a,
+				    gconstpointer b)
+{
+	const BraseroChecksumCacheEntry *entry_a = a;
+	const BraseroChecksumCacheEntry *entry_b = b;
+
+	return entry_a->ino == entry_b->ino
+	    && entry_a->dev == entry_b->dev
+	    && entry_a->type == entry_b->type;
+}
+
+static void
+brasero_checksum_cache_entry_set_key (BraseroChecksumCacheEntry *entry,
+				      GChecksumType type,
+				      struct stat *info)
+{
+	entry->dev = info->st_dev;
+	entry->ino = info->st_ino;
+	entry->size = info->st_size;
+	entry->mtime_ns = (guint64) info->st_mtim.tv_sec * G_GUINT64_CONSTANT (1000000000) +
+			  info->st_mtim.tv_nsec;
+	entry->type = type + 1;
+}
+
+static guint32
+brasero_checksum_cache_now (void)
+{
+	return (guint32) (g_get_real_time () / G_USEC_PER_SEC);
+}
+
+/* Returns the slot holding the key or the empty slot where it should go */
+static BraseroChecksumCacheEntry *
+brasero_checksum_cache_table_find (BraseroChecksumCacheEntry *table,
+				   guint32 slots,
+				   const BraseroChecksumCacheEntry *key)
+{
+	guint32 probes;
+	guint32 i;
+
+	i = brasero_checksum_cache_hash_key (key) & (slots - 1);
+	for (probes = 0; probes < slots; probes ++) {
+		BraseroChecksumCacheEntry *entry;
+
+		entry = table + i;
+		if (!entry->type)
+			return entry;
+
+		if (brasero_checksum_cache_entry_equal (entry, key))
+			return entry;
+
+		i = (i + 1) & (slots - 1);
+	}
+
+	return NULL;
+}
+
+static void
+brasero_checksum_cache_load (BraseroChecksumCache *cache)
+{
+	const BraseroChecksumCacheHeader *header;
+	GError *error = NULL;
+	gsize length;
+
+	cache->mapped = g_mapped_file_new (cache->path, FALSE, &error);
+	if (!cache->mapped) {
+		BRASERO_BURN_LOG ("No checksum cache loaded (%s)", error->message);
+		g_error_free (error);
+		return;
+	}
+
+	length = g_mapped_file_get_length (cache->mapped);
+	header = (const BraseroChecksumCacheHeader *) g_mapped_file_get_contents (cache->mapped);
+
+	if (length < sizeof (BraseroChecksumCacheHeader)
+	||  header->magic != BRASERO_CHECKSUM_CACHE_MAGIC
+	||  header->version != BRASERO_CHECKSUM_CACHE_VERSION
+	||  !header->slots
+	||  (header->slots & (header->slots - 1))
+	||  length != sizeof (BraseroChecksumCacheHeader) + (gsize) header->slots * sizeof (BraseroChecksumCacheEntry)) {
+		BRASERO_BURN_LOG ("Invalid checksum cache, ignoring it");
+		g_mapped_file_unref (cache->mapped);
+		cache->mapped = NULL;
+		return;
+	}
+
+	cache->header = header;
+	cache->table = (BraseroChecksumCacheEntry *) (header + 1);
+
+	BRASERO_BURN_LOG ("Checksum cache with %u entries", header->entries);
+}
+
+/**
+ * brasero_checksum_cache_open:
+ *
+ * Opens the checksum cache of the user.
+ *
+ * Return value: a #BraseroChecksumCache. Close it with
+ * brasero_checksum_cache_close ().
+ **/
+
+BraseroChecksumCache *
+brasero_checksum_cache_open (void)
+{
+	BraseroChecksumCache *cache;
+
+	cache = g_new0 (BraseroChecksumCache, 1);
+	cache->path = g_build_filename (g_get_user_cache_dir (),
+					"brasero",
+					"checksums",
+					NULL);
+	cache->lock = g_mutex_new ();
+	cache->added = g_hash_table_new_full (brasero_checksum_cache_entry_hash,
+					      brasero_checksum_cache_entry_equal,
+					      g_free,
+					      NULL);
+
+	brasero_checksum_cache_load (cache);
+	return cache;
+}
+
+/**
+ * brasero_checksum_cache_lookup:
+ * @cache: a #BraseroChecksumCache
+ * @type: a #GChecksumType
+ * @info: the result of stat () for the file
+ *
+ * Return value: the checksum (as a string) of the file described by @info or
+ * NULL if it isn't in the cache or if the file changed since.
+ **/
+
+gchar *
+brasero_checksum_cache_lookup (BraseroChecksumCache *cache,
+			       GChecksumType type,
+			       struct stat *info)
+{
+	static const gchar hex [] = "0123456789abcdef";
+	BraseroChecksumCacheEntry *entry;
+	BraseroChecksumCacheEntry key;
+	gchar *checksum = NULL;
+	gssize len;
+	gint i;
+
+	len = g_checksum_type_get_length (type);
+	if (len <= 0 || len > BRASERO_CHECKSUM_CACHE_DIGEST_MAX)
+		return NULL;
+
+	memset (&key, 0, sizeof (key));
+	brasero_checksum_cache_entry_set_key (&key, type, info);
+
+	g_mutex_lock (cache->lock);
+
+	entry = g_hash_table_lookup (cache->added, &key);
+	if (!entry && cache->table) {
+		entry = brasero_checksum_cache_table_find (cache->table,
+							   cache->header->slots,
+							   &key);
+		if (entry && !entry->type)
+			entry = NULL;
+
+		/* The mapped table is read only; keep a copy of the entry with
+		 * the new time of use so that it survives the next save */
+		if (entry
+		&&  entry->size == key.size
+		&&  entry->mtime_ns == key.mtime_ns) {
+			entry = g_memdup (entry, sizeof (BraseroChecksumCacheEntry));
+			g_hash_table_replace (cache->added, entry, entry);
+		}
+	}
+
+	if (entry
+	&&  entry->size == key.size
+	&&  entry->mtime_ns == key.mtime_ns) {
+		checksum = g_malloc (len * 2 + 1);
+		for (i = 0; i < len; i ++) {
+			checksum [i * 2] = hex [entry->digest [i] >> 4];
+			checksum [i * 2 + 1] = hex [entry->digest [i] & 0x0F];
+		}
+		checksum [len * 2] = '\0';
+		entry->last_used = brasero_checksum_cache_now ();
+		cache->hits ++;
+	}
+	else
+		cache->misses ++;
+
+	g_mutex_unlock (cache->lock);
+
+	return checksum;
+}
+
+/**
+ * brasero_checksum_cache_insert:
+ * @cache: a #BraseroChecksumCache
+ * @type: a #GChecksumType
+ * @info: the result of stat () for the file before it was read
+ * @checksum: the checksum (as a string) of the file
+ *
+ * Records @checksum for the file described by @info.
+ **/
+
+void
+brasero_checksum_cache_insert (BraseroChecksumCache *cache,
+			       GChecksumType type,
+			       struct stat *info,
+			       const gchar *checksum)
+{
+	BraseroChecksumCacheEntry *entry;
+	gssize len;
+	gint i;
+
+	len = g_checksum_type_get_length (type);
+	if (len <= 0 || len > BRASERO_CHECKSUM_CACHE_DIGEST_MAX)
+		return;
+
+	if ((gssize) strlen (checksum) != len * 2)
+		return;
+
+	entry = g_new0 (BraseroChecksumCacheEntry, 1);
+	brasero_checksum_cache_entry_set_key (entry, type, info);
+	entry->last_used = brasero_checksum_cache_now ();
+
+	for (i = 0; i < len; i ++) {
+		gint high, low;
+
+		high = g_ascii_xdigit_value (checksum [i * 2]);
+		low = g_ascii_xdigit_value (checksum [i * 2 + 1]);
+		if (high < 0 || low < 0) {
+			g_free (entry);
+			return;
+		}
+
+		entry->digest [i] = (high << 4) | low;
+	}
+
+	g_mutex_lock (cache->lock);
+	g_hash_table_replace (cache->added, entry, entry);
+	g_mutex_unlock (cache->lock);
+}
+
+void
+brasero_checksum_cache_get_stats (BraseroChecksumCache *cache,
+				  guint64 *hits,
+				  guint64 *misses)
+{
+	g_mutex_lock (cache->lock);
+
+	if (hits)
+		*hits = cache->hits;
+	if (misses)
+		*misses = cache->misses;
+
+	g_mutex_unlock (cache->lock);
+}
+
+static gboolean
+brasero_checksum_cache_write (BraseroChecksumCache *cache,
+			      BraseroChecksumCacheHeader *header,
+			      BraseroChecksumCacheEntry *table)
+{
+	gchar *tmp_path;
+	gchar *dir;
+	FILE *file;
+	int fd;
+
+	dir = g_path_get_dirname (cache->path);
+	g_mkdir_with_parents (dir, 0700);
+	g_free (dir);
+
+	/* Write a new file and replace the old one so that a crash or another
+	 * instance never sees a half written table */
+	tmp_path = g_strconcat (cache->path, ".XXXXXX", NULL);
+	fd = g_mkstemp (tmp_path);
+	if (fd < 0) {
+		BRASERO_BURN_LOG ("Checksum cache not saved (%s)", g_strerror (errno));
+		g_free (tmp_path);
+		return FALSE;
+	}
+
+	file = fdopen (fd, "w");
+	if (!file) {
+		close (fd);
+		g_remove (tmp_path);
+		g_free (tmp_path);
+		return FALSE;
+	}
+
+	if (fwrite (header, sizeof (BraseroChecksumCacheHeader), 1, file) != 1
+	||  fwrite (table, sizeof (BraseroChecksumCacheEntry), header->slots, file) != header->slots) {
+		BRASERO_BURN_LOG ("Checksum cache not saved (%s)", g_strerror (errno));
+		fclose (file);
+		g_remove (tmp_path);
+		g_free (tmp_path);
+		return FALSE;
+	}
+
+	if (fclose (file) || g_rename (tmp_path, cache->path)) {
+		BRASERO_BURN_LOG ("Checksum cache not saved (%s)", g_strerror (errno));
+		g_remove (tmp_path);
+		g_free (tmp_path);
+		return FALSE;
+	}
+
+	g_free (tmp_path);
+	return TRUE;
+}
+
+static gint
+brasero_checksum_cache_entry_compare_use (gconstpointer a,
+					  gconstpointer b)
+{
+	const BraseroChecksumCacheEntry *entry_a = *(BraseroChecksumCacheEntry **) a;
+	const BraseroChecksumCacheEntry *entry_b = *(BraseroChecksumCacheEntry **) b;
+
+	/* most recently used first */
+	if (entry_a->last_used > entry_b->last_used)
+		return -1;
+	if (entry_a->last_used < entry_b->last_used)
+		return 1;
+	return 0;
+}
+
+static void
+brasero_checksum_cache_save (BraseroChecksumCache *cache)
+{
+	BraseroChecksumCacheHeader header;
+	BraseroChecksumCacheEntry *table;
+	BraseroChecksumCacheEntry *entry;
+	GHashTableIter iter;
+	GPtrArray *entries;
+	guint32 slots;
+	guint num;
+	guint i;
+
+	/* New or refreshed entries replace the old ones for the same files */
+	entries = g_ptr_array_sized_new (g_hash_table_size (cache->added) +
+					 (cache->header ? cache->header->entries : 0));
+
+	g_hash_table_iter_init (&iter, cache->added);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &entry, NULL))
+		g_ptr_array_add (entries, entry);
+
+	for (i = 0; cache->table && i < cache->header->slots; i ++) {
+		entry = cache->table + i;
+		if (!entry->type)
+			continue;
+
+		if (g_hash_table_lookup (cache->added, entry))
+			continue;
+
+		g_ptr_array_add (entries, entry);
+	}
+
+	/* When there are too many entries drop the least recently used */
+	num = entries->len;
+	if (num > BRASERO_CHECKSUM_CACHE_MAX_ENTRIES) {
+		g_ptr_array_sort (entries, brasero_checksum_cache_entry_compare_use);
+		num = BRASERO_CHECKSUM_CACHE_MAX_ENTRIES;
+	}
+
+	/* keep the table half empty at most */
+	slots = 16;
+	while (slots < num * 2)
+		slots <<= 1;
+
+	table = g_new0 (BraseroChecksumCacheEntry, slots);
+
+	memset (&header, 0, sizeof (header));
+	header.magic = BRASERO_CHECKSUM_CACHE_MAGIC;
+	header.version = BRASERO_CHECKSUM_CACHE_VERSION;
+	header.slots = slots;
+
+	for (i = 0; i < num; i ++) {
+		BraseroChecksumCacheEntry *slot;
+
+		entry = g_ptr_array_index (entries, i);
+		slot = brasero_checksum_cache_table_find (table, slots, entry);
+		if (slot && !slot->type) {
+			*slot = *entry;
+			header.entries ++;
+		}
+	}
+
+	if (brasero_checksum_cache_write (cache, &header, table))
+		BRASERO_BURN_LOG ("Checksum cache saved with %u entries (%u dropped)",
+				  header.entries,
+				  entries->len - header.entries);
+
+	g_ptr_array_free (entries, TRUE);
+	g_free (table);
+}
+
+/**
+ * brasero_checksum_cache_close:
+ * @cache: a #BraseroChecksumCache
+ *
+ * Saves the new entries (if any) and frees @cache.
+ **/
+
+void
+brasero_checksum_cache_close (BraseroChecksumCache *cache)
+{
+	if (g_hash_table_size (cache->added))
+		brasero_checksum_cache_save (cache);
+
+	if (cache->mapped)
+		g_mapped_file_unref (cache->mapped);
+
+	g_hash_table_destroy (cache->added);
+	g_mutex_free (cache->lock);
+	g_free (cache->path);
+	g_free (cache);
+}
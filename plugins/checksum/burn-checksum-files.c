@@ -36,6 +36,7 @@
 #include <string.h>
 #include <errno.h>
 #include <ctype.h>
+#include <unistd.h>
 #include <sys/param.h>
 
 #include <glib.h>
@@ -54,10 +55,12 @@
 #include "brasero-track-disc.h"
 
 #include "burn-volume.h"
+#include "burn-volume-index.h"
 #include "brasero-drive.h"
 #include "brasero-volume.h"
 
 #include "burn-volume-read.h"
+#include "burn-checksum-cache.h"
 
 
 #define BRASERO_TYPE_CHECKSUM_FILES		(brasero_checksum_files_get_type ())
@@ -75,10 +78,22 @@ struct _BraseroChecksumFilesPrivate {
 	BraseroChecksumType checksum_type;
 
 	gint64 file_num;
+	gint64 file_nb;
 
 	/* the FILE to write to when we generate */
 	FILE *file;
 
+	/* Files are hashed by a pool of threads; items are queued in the
+	 * order their lines must be written to the file. */
+	GThreadPool *pool;
+	GQueue *items;
+	GMutex *items_mutex;
+	GCond *items_cond;
+	guint max_items;
+
+	/* checksums of the files hashed during former runs */
+	BraseroChecksumCache *cache;
+
 	/* this is for the thread and the end of it */
 	GThread *thread;
 	GMutex *mutex;
@@ -91,7 +106,13 @@ typedef struct _BraseroChecksumFilesPrivate BraseroChecksumFilesPrivate;
 
 #define BRASERO_CHECKSUM_FILES_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_CHECKSUM_FILES, BraseroChecksumFilesPrivate))
 
-#define BLOCK_SIZE			64
+#define BLOCK_SIZE			65536
+
+/* Maximum number of files read at the same time when generating */
+#define BRASERO_CHECKSUM_FILES_MAX_IO		4
+
+/* Maximum number of files queued per thread */
+#define BRASERO_CHECKSUM_FILES_ITEMS_PER_THREAD	64
 
 #define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
 #define BRASERO_PROPS_CHECKSUM_FILES	"checksum-files"
@@ -106,13 +127,25 @@ brasero_checksum_files_get_file_checksum (BraseroChecksumFiles *self,
 					  GError **error)
 {
 	BraseroChecksumFilesPrivate *priv;
-	guchar buffer [BLOCK_SIZE];
+	gboolean cacheable = FALSE;
 	GChecksum *checksum;
+	struct stat info;
+	guchar *buffer;
 	gint read_bytes;
 	FILE *file;
 
 	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
 
+	/* NOTE: stat () before reading so that if the file is modified while
+	 * it is read, the entry won't be valid */
+	if (priv->cache && !g_stat (path, &info) && S_ISREG (info.st_mode)) {
+		*checksum_string = brasero_checksum_cache_lookup (priv->cache, type, &info);
+		if (*checksum_string)
+			return BRASERO_BURN_OK;
+
+		cacheable = TRUE;
+	}
+
 	file = fopen (path, "r");
 	if (!file) {
                 int errsv;
@@ -138,12 +171,16 @@ brasero_checksum_files_get_file_checksum (BraseroChecksumFiles *self,
 
 	checksum = g_checksum_new (type);
 
+	/* This is called from several threads at the same time */
+	buffer = g_malloc (BLOCK_SIZE);
+
 	read_bytes = fread (buffer, 1, BLOCK_SIZE, file);
 	g_checksum_update (checksum, buffer, read_bytes);
 
 	while (read_bytes == BLOCK_SIZE) {
 		if (priv->cancel) {
 			fclose (file);
+			g_free (buffer);
 			g_checksum_free (checksum);
 			return BRASERO_BURN_CANCEL;
 		}
@@ -154,39 +191,34 @@ brasero_checksum_files_get_file_checksum (BraseroChecksumFiles *self,
 
 	*checksum_string = g_strdup (g_checksum_get_string (checksum));
 	g_checksum_free (checksum);
+	g_free (buffer);
+
+	/* Only cache it if the whole file was read */
+	if (cacheable && !ferror (file))
+		brasero_checksum_cache_insert (priv->cache, type, &info, *checksum_string);
+
 	fclose (file);
 
 	return BRASERO_BURN_OK;
 }
 
 static BraseroBurnResult
-brasero_checksum_files_add_file_checksum (BraseroChecksumFiles *self,
-					  const gchar *path,
-					  GChecksumType checksum_type,
-					  const gchar *graft_path,
-					  GError **error)
+brasero_checksum_files_write_checksum (BraseroChecksumFiles *self,
+				       const gchar *checksum_string,
+				       const gchar *graft_path,
+				       GError **error)
 {
 	BraseroBurnResult result = BRASERO_BURN_OK;
 	BraseroChecksumFilesPrivate *priv;
-	gchar *checksum_string = NULL;
 	gint written;
 
 	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
 
 	/* write to the file */
-	result = brasero_checksum_files_get_file_checksum (self,
-							   checksum_type,
-							   path,
-							   &checksum_string,
-							   error);
-	if (result != BRASERO_BURN_OK)
-		return BRASERO_BURN_ERR;
-
 	written = fwrite (checksum_string,
 			  strlen (checksum_string),
 			  1,
 			  priv->file);
-	g_free (checksum_string);
 
 	if (written != 1) {
                 int errsv = errno;
@@ -230,10 +262,206 @@ brasero_checksum_files_add_file_checksum (BraseroChecksumFiles *self,
 	return result;
 }
 
+/**
+ * Files are hashed concurrently by a pool of threads. Each file gets an item
+ * that is queued (in the order files are found) and handed to the pool; once
+ * the item at the head of the queue is hashed, its line is written. That way
+ * the order of the lines doesn't depend on the order hashing finishes.
+ */
+
+struct _BraseroChecksumFilesItem {
+	gchar *path;
+	gchar *graft_path;
+	GChecksumType type;
+
+	gchar *checksum;
+	GError *error;
+	BraseroBurnResult result;
+	guint done:1;
+};
+typedef struct _BraseroChecksumFilesItem BraseroChecksumFilesItem;
+
+static void
+brasero_checksum_files_item_free (BraseroChecksumFilesItem *item)
+{
+	if (item->error)
+		g_error_free (item->error);
+
+	g_free (item->checksum);
+	g_free (item->graft_path);
+	g_free (item->path);
+	g_free (item);
+}
+
+static void
+brasero_checksum_files_hash_item (gpointer data,
+				  gpointer user_data)
+{
+	BraseroChecksumFilesItem *item = data;
+	BraseroChecksumFiles *self = user_data;
+	BraseroChecksumFilesPrivate *priv;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	if (priv->cancel)
+		item->result = BRASERO_BURN_CANCEL;
+	else
+		item->result = brasero_checksum_files_get_file_checksum (self,
+									 item->type,
+									 item->path,
+									 &item->checksum,
+									 &item->error);
+
+	g_mutex_lock (priv->items_mutex);
+	item->done = TRUE;
+	g_cond_broadcast (priv->items_cond);
+	g_mutex_unlock (priv->items_mutex);
+}
+
+static BraseroBurnResult
+brasero_checksum_files_write_items (BraseroChecksumFiles *self,
+				    gboolean wait_all,
+				    GError **error)
+{
+	BraseroBurnResult result = BRASERO_BURN_OK;
+	BraseroChecksumFilesPrivate *priv;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	g_mutex_lock (priv->items_mutex);
+	while (result == BRASERO_BURN_OK) {
+		BraseroChecksumFilesItem *item;
+
+		item = g_queue_peek_head (priv->items);
+		if (!item)
+			break;
+
+		if (!item->done) {
+			/* Only wait when asked or when too many files are
+			 * queued already */
+			if (!wait_all && g_queue_get_length (priv->items) < priv->max_items)
+				break;
+
+			g_cond_wait (priv->items_cond, priv->items_mutex);
+			continue;
+		}
+
+		g_queue_pop_head (priv->items);
+		g_mutex_unlock (priv->items_mutex);
+
+		if (item->result == BRASERO_BURN_CANCEL)
+			result = BRASERO_BURN_CANCEL;
+		else if (item->result != BRASERO_BURN_OK) {
+			if (item->error) {
+				g_propagate_error (error, item->error);
+				item->error = NULL;
+			}
+			result = BRASERO_BURN_ERR;
+		}
+		else {
+			result = brasero_checksum_files_write_checksum (self,
+									item->checksum,
+									item->graft_path,
+									error);
+
+			priv->file_num ++;
+			brasero_job_set_progress (BRASERO_JOB (self),
+						  (gdouble) priv->file_num /
+						  (gdouble) priv->file_nb);
+		}
+
+		brasero_checksum_files_item_free (item);
+		g_mutex_lock (priv->items_mutex);
+	}
+	g_mutex_unlock (priv->items_mutex);
+
+	return result;
+}
+
+static BraseroBurnResult
+brasero_checksum_files_add_file_checksum (BraseroChecksumFiles *self,
+					  const gchar *path,
+					  GChecksumType checksum_type,
+					  const gchar *graft_path,
+					  GError **error)
+{
+	BraseroChecksumFilesPrivate *priv;
+	BraseroChecksumFilesItem *item;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	item = g_new0 (BraseroChecksumFilesItem, 1);
+	item->path = g_strdup (path);
+	item->graft_path = g_strdup (graft_path);
+	item->type = checksum_type;
+
+	g_mutex_lock (priv->items_mutex);
+	g_queue_push_tail (priv->items, item);
+	g_mutex_unlock (priv->items_mutex);
+
+	g_thread_pool_push (priv->pool, item, NULL);
+
+	/* write what's ready */
+	return brasero_checksum_files_write_items (self, FALSE, error);
+}
+
+static void
+brasero_checksum_files_start_pool (BraseroChecksumFiles *self)
+{
+	BraseroChecksumFilesPrivate *priv;
+	glong threads;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	/* as many threads as cores but without reading too many files at
+	 * the same time */
+	threads = sysconf (_SC_NPROCESSORS_ONLN);
+	threads = CLAMP (threads, 1, BRASERO_CHECKSUM_FILES_MAX_IO);
+
+	BRASERO_JOB_LOG (self, "Hashing files with %li threads", threads);
+
+	priv->items = g_queue_new ();
+	priv->max_items = threads * BRASERO_CHECKSUM_FILES_ITEMS_PER_THREAD;
+	priv->cache = brasero_checksum_cache_open ();
+	priv->pool = g_thread_pool_new (brasero_checksum_files_hash_item,
+					self,
+					threads,
+					FALSE,
+					NULL);
+}
+
+static void
+brasero_checksum_files_stop_pool (BraseroChecksumFiles *self)
+{
+	BraseroChecksumFilesPrivate *priv;
+
+	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
+
+	/* drop the files that weren't hashed yet and wait for the others */
+	g_thread_pool_free (priv->pool, TRUE, TRUE);
+	priv->pool = NULL;
+
+	g_queue_foreach (priv->items, (GFunc) brasero_checksum_files_item_free, NULL);
+	g_queue_free (priv->items);
+	priv->items = NULL;
+
+	if (priv->cache) {
+		guint64 hits, misses;
+
+		brasero_checksum_cache_get_stats (priv->cache, &hits, &misses);
+		BRASERO_JOB_LOG (self,
+				 "Checksum cache: %" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT " misses",
+				 hits,
+				 misses);
+
+		brasero_checksum_cache_close (priv->cache);
+		priv->cache = NULL;
+	}
+}
+
 static BraseroBurnResult
 brasero_checksum_files_explore_directory (BraseroChecksumFiles *self,
 					  GChecksumType checksum_type,
-					  gint64 file_nb,
 					  const gchar *directory,
 					  const gchar *disc_path,
 					  GHashTable *excludedH,
@@ -269,7 +497,6 @@ brasero_checksum_files_explore_directory (BraseroChecksumFiles *self,
 		if (g_file_test (path, G_FILE_TEST_IS_DIR)) {
 			result = brasero_checksum_files_explore_directory (self,
 									   checksum_type,
-									   file_nb,
 									   path,
 									   graft_path,
 									   excludedH,
@@ -300,11 +527,6 @@ brasero_checksum_files_explore_directory (BraseroChecksumFiles *self,
 
 		if (result != BRASERO_BURN_OK)
 			break;
-
-		priv->file_num ++;
-		brasero_job_set_progress (BRASERO_JOB (self),
-					  (gdouble) priv->file_num /
-					  (gdouble) file_nb);
 	}
 	g_dir_close (dir);
 
@@ -625,6 +847,9 @@ brasero_checksum_files_create_checksum (BraseroChecksumFiles *self,
 	else
 		file_nb = -1;
 
+	priv->file_nb = file_nb;
+	brasero_checksum_files_start_pool (self);
+
 	iter = brasero_track_data_get_grafts (BRASERO_TRACK_DATA (track));
 	for (; iter; iter = iter->next) {
 		BraseroGraftPt *graft;
@@ -657,28 +882,28 @@ brasero_checksum_files_create_checksum (BraseroChecksumFiles *self,
 		if (g_file_test (path, G_FILE_TEST_IS_DIR))
 			result = brasero_checksum_files_explore_directory (self,
 									   gchecksum_type,
-									   file_nb,
 									   path,
 									   graft_path,
 									   excludedH,
 									   error);
-		else {
+		else
 			result = brasero_checksum_files_add_file_checksum (self,
 									   path,
 									   gchecksum_type,
 									   graft_path,
 									   error);
-			priv->file_num ++;
-			brasero_job_set_progress (BRASERO_JOB (self),
-						  (gdouble) priv->file_num /
-						  (gdouble) file_nb);
-		}
 
 		g_free (path);
 		if (result != BRASERO_BURN_OK)
 			break;
 	}
 
+	/* write the remaining lines */
+	if (result == BRASERO_BURN_OK)
+		result = brasero_checksum_files_write_items (self, TRUE, error);
+
+	brasero_checksum_files_stop_pool (self);
+
 	g_hash_table_destroy (excludedH);
 
 	if (result == BRASERO_BURN_OK)
@@ -699,37 +924,54 @@ brasero_checksum_files_sum_on_disc_file (BraseroChecksumFiles *self,
 					 gchar **checksum_string,
 					 GError **error)
 {
-	guchar buffer [64 * 2048];
 	BraseroChecksumFilesPrivate *priv;
 	BraseroVolFileHandle *handle;
 	GChecksum *checksum;
-	gint read_bytes;
+	gint64 read_bytes;
+	guchar *buffer;
+	guint blocks;
 
 	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
 
+	/* Contents are read from the drive itself, not through the cache used
+	 * for directory records; the read size is tuned on it too */
+	src = brasero_volume_source_get_uncached (src);
 	handle = brasero_volume_file_open_direct (src, file);
 	if (!handle)
 		return BRASERO_BURN_ERR;
 
 	checksum = g_checksum_new (type);
 
+	/* The size of reads is tuned by the source */
+	buffer = g_malloc (brasero_volume_source_get_max_transfer (src) * 2048);
+
+	blocks = brasero_volume_source_get_transfer (src);
 	read_bytes = brasero_volume_file_read_direct (handle,
 						      buffer,
-						      64);
-	g_checksum_update (checksum, buffer, read_bytes);
+						      blocks);
+	if (read_bytes > 0)
+		g_checksum_update (checksum, buffer, read_bytes);
 
-	while (read_bytes == sizeof (buffer)) {
+	while (read_bytes == blocks * 2048) {
 		if (priv->cancel) {
+			g_free (buffer);
+			g_checksum_free (checksum);
 			brasero_volume_file_close (handle);
 			return BRASERO_BURN_CANCEL;
 		}
 
+		blocks = brasero_volume_source_get_transfer (src);
 		read_bytes = brasero_volume_file_read_direct (handle,
 							      buffer,
-							      64);
-		g_checksum_update (checksum, buffer, read_bytes);
+							      blocks);
+		if (read_bytes > 0)
+			g_checksum_update (checksum, buffer, read_bytes);
 	}
 
+	g_free (buffer);
+
+	/* NOTE: after a read error the checksum won't match and the file will
+	 * be reported as corrupted */
 	*checksum_string = g_strdup (g_checksum_get_string (checksum));
 	g_checksum_free (checksum);
 
@@ -808,6 +1050,46 @@ brasero_checksum_files_get_line_num (BraseroChecksumFiles *self,
 	return num;
 }
 
+struct _BraseroChecksumFilesEntry {
+	gchar *path;
+	gchar *checksum;
+	BraseroVolFile *file;
+
+	/* address of the first extent on the disc */
+	guint block;
+
+	/* whether file belongs to the volume index or to us */
+	guint owned:1;
+};
+typedef struct _BraseroChecksumFilesEntry BraseroChecksumFilesEntry;
+
+static void
+brasero_checksum_files_entry_free (BraseroChecksumFilesEntry *entry)
+{
+	if (entry->owned)
+		brasero_volume_file_free (entry->file);
+
+	g_free (entry->checksum);
+	g_free (entry->path);
+	g_free (entry);
+}
+
+static gint
+brasero_checksum_files_entry_compare (gconstpointer a,
+				      gconstpointer b)
+{
+	const BraseroChecksumFilesEntry *entry_a = a;
+	const BraseroChecksumFilesEntry *entry_b = b;
+
+	if (entry_a->block < entry_b->block)
+		return -1;
+
+	if (entry_a->block > entry_b->block)
+		return 1;
+
+	return 0;
+}
+
 static BraseroBurnResult
 brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 				    GError **error)
@@ -829,6 +1111,9 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 	BraseroChecksumFilesPrivate *priv;
 	BraseroVolFileHandle *handle = NULL;
 	BraseroBurnResult result = BRASERO_BURN_OK;
+	BraseroVolIndex *index = NULL;
+	GSList *entries = NULL;
+	GSList *iter;
 
 	priv = BRASERO_CHECKSUM_FILES_PRIVATE (self);
 
@@ -847,6 +1132,14 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 		return BRASERO_BURN_ERROR;
 
 	vol = brasero_volume_source_open_device_handle (dev_handle, error);
+	if (vol) {
+		BraseroVolSrc *cache;
+
+		/* Looking up files means reading lots of single blocks */
+		cache = brasero_volume_source_open_cache (vol, BRASERO_VOL_SRC_CACHE_DEFAULT_BLOCKS);
+		brasero_volume_source_close (vol);
+		vol = cache;
+	}
 
 	/* open checksum file */
 	file = brasero_checksum_files_get_on_disc_checksum_type (self,
@@ -910,12 +1203,23 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 		break;
 	}
 
+	/* Load the whole directory hierarchy once so that looking up the files
+	 * does not mean reading the directory records from root every time */
+	index = brasero_volume_index_new (vol, start_block, NULL);
+	if (!index)
+		BRASERO_JOB_LOG (self, "No volume index, looking up files one by one");
+
+	/* First resolve all the paths listed in the checksum file to their
+	 * extents on the disc. Then verify them sorted by their address so
+	 * that the disc is read from start to end instead of seeking all over
+	 * it (files are listed in the order of the graft points). */
 	checksum_len = g_checksum_type_get_length (gchecksum_type) * 2;
 	while (1) {
 		gchar file_path [MAXPATHLEN + 1];
 		gchar checksum_file [512 + 1];
+		BraseroChecksumFilesEntry *entry;
 		BraseroVolFile *disc_file;
-		gchar *checksum_real;
+		gboolean owned;
 		gint read_bytes;
 
 		if (priv->cancel)
@@ -946,7 +1250,7 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 			read_bytes = brasero_volume_file_read (handle, c, 1);
 			if (read_bytes == 0) {
 				result = BRASERO_BURN_OK;
-				goto end;
+				goto check;
 			}
 
 			if (read_bytes < 0) {
@@ -972,14 +1276,23 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 			break;
 		}
 
-		checksum_real = NULL;
+		/* BRASERO_BURN_RETRY only means there are more lines */
+		result = BRASERO_BURN_OK;
 
 		/* get the file handle itself */
-		BRASERO_JOB_LOG (self, "Getting file %s", file_path);
-		disc_file = brasero_volume_get_file (vol,
-						     file_path,
-						     start_block,
-						     NULL);
+		owned = FALSE;
+		disc_file = NULL;
+		if (index)
+			disc_file = brasero_volume_index_get_file (index, file_path);
+
+		if (!disc_file) {
+			owned = TRUE;
+			disc_file = brasero_volume_get_file (vol,
+							     file_path,
+							     start_block,
+							     NULL);
+		}
+
 		if (!disc_file) {
 			g_set_error (error,
 				     BRASERO_BURN_ERROR,
@@ -997,20 +1310,53 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 		 * }
 		 */
 
+		entry = g_new0 (BraseroChecksumFilesEntry, 1);
+		entry->path = g_strdup (file_path);
+		entry->checksum = g_strdup (checksum_file);
+		entry->file = disc_file;
+		entry->owned = owned;
+		if (!disc_file->isdir && disc_file->specific.file.extents) {
+			BraseroVolFileExtent *extent;
+
+			extent = disc_file->specific.file.extents->data;
+			entry->block = extent->block;
+		}
+
+		entries = g_slist_prepend (entries, entry);
+	}
+
+check:
+
+	if (result != BRASERO_BURN_OK || priv->cancel)
+		goto end;
+
+	entries = g_slist_sort (entries, brasero_checksum_files_entry_compare);
+	BRASERO_JOB_LOG (self, "Checking %i files in disc order", g_slist_length (entries));
+
+	for (iter = entries; iter; iter = iter->next) {
+		BraseroChecksumFilesEntry *entry;
+		gchar *checksum_real;
+
+		if (priv->cancel)
+			break;
+
+		entry = iter->data;
+		checksum_real = NULL;
+
 		/* checksum the file */
+		BRASERO_JOB_LOG (self, "Getting file %s (block %i)", entry->path, entry->block);
 		result = brasero_checksum_files_sum_on_disc_file (self,
 								  gchecksum_type,
 								  vol,
-								  disc_file,
+								  entry->file,
 								  &checksum_real,
 								  error);
-		brasero_volume_file_free (disc_file);
 		if (result == BRASERO_BURN_ERR) {
 			g_set_error (error,
 				     BRASERO_BURN_ERROR,
 				     BRASERO_BURN_ERROR_GENERAL,
 				     _("File \"%s\" could not be opened"),
-				     file_path);
+				     entry->path);
 			break;
 		}
 
@@ -1023,9 +1369,9 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 					  (gdouble) file_nb);
 		BRASERO_JOB_LOG (self,
 				 "comparing checksums for file %s : %s (from md5 file) / %s (current)",
-				 file_path, checksum_file, checksum_real);
+				 entry->path, entry->checksum, checksum_real);
 
-		if (strcmp (checksum_file, checksum_real)) {
+		if (strcmp (entry->checksum, checksum_real)) {
 			gchar *string;
 
 			BRASERO_JOB_LOG (self, "Wrong checksum");
@@ -1034,17 +1380,21 @@ brasero_checksum_files_check_files (BraseroChecksumFiles *self,
 							       TRUE, 
 							       sizeof (gchar *));
 
-			string = g_strdup (file_path);
+			string = g_strdup (entry->path);
 			wrong_checksums = g_array_append_val (wrong_checksums, string);
 		}
 
 		g_free (checksum_real);
-		if (priv->cancel)
-			break;
 	}
 
 end:
 
+	g_slist_foreach (entries, (GFunc) brasero_checksum_files_entry_free, NULL);
+	g_slist_free (entries);
+
+	if (index)
+		brasero_volume_index_unref (index);
+
 	if (handle)
 		brasero_volume_file_close (handle);
 
@@ -1394,6 +1744,9 @@ brasero_checksum_files_init (BraseroChecksumFiles *obj)
 
 	priv->mutex = g_mutex_new ();
 	priv->cond = g_cond_new ();
+
+	priv->items_mutex = g_mutex_new ();
+	priv->items_cond = g_cond_new ();
 }
 
 static void
@@ -1432,6 +1785,16 @@ brasero_checksum_files_finalize (GObject *object)
 		priv->cond = NULL;
 	}
 
+	if (priv->items_mutex) {
+		g_mutex_free (priv->items_mutex);
+		priv->items_mutex = NULL;
+	}
+
+	if (priv->items_cond) {
+		g_cond_free (priv->items_cond);
+		priv->items_cond = NULL;
+	}
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -33,6 +33,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <ctype.h>
@@ -49,6 +50,7 @@
 
 #include "brasero-plugin-registration.h"
 #include "burn-job.h"
+#include "burn-job-io.h"
 #include "burn-volume.h"
 #include "brasero-drive.h"
 #include "brasero-track-disc.h"
@@ -65,13 +67,70 @@
 
 BRASERO_PLUGIN_BOILERPLATE (BraseroChecksumImage, brasero_checksum_image, BRASERO_TYPE_JOB, BraseroJob);
 
+/* All the digests are computed during the same read pass; the one matching
+ * the checksum type of the track is used for brasero_track_set_checksum ()
+ * and all of them are recorded in the track tags. */
+static const struct {
+	BraseroChecksumType type;
+	GChecksumType checksum_type;
+	const gchar *tag;
+} brasero_checksum_image_algos [] = {
+	{ BRASERO_CHECKSUM_MD5, G_CHECKSUM_MD5, BRASERO_TRACK_CHECKSUM_MD5_TAG },
+	{ BRASERO_CHECKSUM_SHA1, G_CHECKSUM_SHA1, BRASERO_TRACK_CHECKSUM_SHA1_TAG },
+	{ BRASERO_CHECKSUM_SHA256, G_CHECKSUM_SHA256, BRASERO_TRACK_CHECKSUM_SHA256_TAG },
+};
+
+#define BRASERO_CHECKSUM_IMAGE_ALGO_NUM		G_N_ELEMENTS (brasero_checksum_image_algos)
+
+/* Size of the buffer used to read the image. It has to be big enough for
+ * reads not to be syscall bound (images can be several tens of GiB). */
+#define BRASERO_CHECKSUM_IMAGE_BUFFER_SIZE	(2048 * 512)
+
+/* Number of buffers in the ring shared by the reader thread and the hashing
+ * thread. Reads and hashing overlap as long as it is not full or empty. */
+#define BRASERO_CHECKSUM_IMAGE_RING_SIZE	4
+
+struct _BraseroChecksumImageBuffer {
+	guchar *data;
+	gint bytes;
+
+	/* Set when the data was already duplicated to the output by tee () */
+	guint teed:1;
+};
+typedef struct _BraseroChecksumImageBuffer BraseroChecksumImageBuffer;
+
 struct _BraseroChecksumImagePrivate {
-	GChecksum *checksum;
+	GChecksum *checksums [BRASERO_CHECKSUM_IMAGE_ALGO_NUM];
 	BraseroChecksumType checksum_type;
 
 	/* That's for progress reporting */
 	goffset total;
 	goffset bytes;
+	GTimer *timer;
+
+	/* Ring of buffers filled by the reader thread and emptied by the
+	 * hashing thread. The stall counters record how many times one thread
+	 * had to wait for the other: that tells which one is the bottleneck. */
+	BraseroChecksumImageBuffer ring [BRASERO_CHECKSUM_IMAGE_RING_SIZE];
+	GMutex *ring_mutex;
+	GCond *ring_cond;
+	guint ring_head;
+	guint ring_tail;
+	guint ring_filled;
+	guint reader_stalls;
+	guint hasher_stalls;
+	guint last_stalls;
+
+	/* Set by the reader thread when it stops */
+	int reader_fd;
+	int tee_fd;
+	BraseroBurnResult reader_result;
+	GError *reader_error;
+	guint reader_done:1;
+
+	/* Set by the hashing thread to stop the reader. It is not a bit field
+	 * since the reader checks it without the lock while it waits for data */
+	gint reader_abort;
 
 	/* this is for the thread and the end of it */
 	GThread *thread;
@@ -90,6 +149,17 @@ typedef struct _BraseroChecksumImagePrivate BraseroChecksumImagePrivate;
 
 static BraseroJobClass *parent_class = NULL;
 
+/* The reader thread stops when the job is cancelled but also when the hashing
+ * thread stopped on an error and waits for it to join. */
+static gboolean
+brasero_checksum_image_stopped (BraseroChecksumImage *self)
+{
+	BraseroChecksumImagePrivate *priv;
+
+	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
+	return priv->cancel || g_atomic_int_get (&priv->reader_abort);
+}
+
 static gint
 brasero_checksum_image_read (BraseroChecksumImage *self,
 			     int fd,
@@ -99,9 +169,6 @@ brasero_checksum_image_read (BraseroChecksumImage *self,
 {
 	gint total = 0;
 	gint read_bytes;
-	BraseroChecksumImagePrivate *priv;
-
-	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
 
 	while (1) {
 		read_bytes = read (fd, buffer + total, (bytes - total));
@@ -110,7 +177,7 @@ brasero_checksum_image_read (BraseroChecksumImage *self,
 		if (!read_bytes)
 			return total;
 
-		if (priv->cancel)
+		if (brasero_checksum_image_stopped (self))
 			return -2;
 
 		/* ... or an error =( */
@@ -125,6 +192,16 @@ brasero_checksum_image_read (BraseroChecksumImage *self,
 					     g_strerror (errsv));
 				return -1;
 			}
+
+			/* No need to wait for the buffer to be full when
+			 * reading from a pipe: hash what we already have */
+			if (errno == EAGAIN && total)
+				return total;
+
+			/* Sleep until there is data; wake up now and then
+			 * to see if we should stop */
+			if (errno == EAGAIN)
+				brasero_job_io_wait_input (fd);
 		}
 		else {
 			total += read_bytes;
@@ -132,8 +209,6 @@ brasero_checksum_image_read (BraseroChecksumImage *self,
 			if (total == bytes)
 				return total;
 		}
-
-		g_usleep (500);
 	}
 
 	return total;
@@ -146,103 +221,392 @@ brasero_checksum_image_write (BraseroChecksumImage *self,
 			      gint bytes,
 			      GError **error)
 {
-	gint bytes_remaining;
-	gint bytes_written = 0;
+	gsize bytes_written = 0;
 	BraseroChecksumImagePrivate *priv;
 
 	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
 
-	bytes_remaining = bytes;
-	while (bytes_remaining) {
-		gint written;
+	while (bytes_written < bytes) {
+		BraseroBurnResult result;
+		gsize written = 0;
 
-		written = write (fd,
-				 buffer + bytes_written,
-				 bytes_remaining);
+		result = brasero_job_io_write (fd,
+					       buffer + bytes_written,
+					       bytes - bytes_written,
+					       &written,
+					       error);
+		bytes_written += written;
 
 		if (priv->cancel)
 			return BRASERO_BURN_CANCEL;
 
-		if (written != bytes_remaining) {
-			if (errno != EINTR && errno != EAGAIN) {
-                                int errsv = errno;
+		if (result == BRASERO_BURN_ERR)
+			return result;
+	}
 
-				/* unrecoverable error */
-				g_set_error (error,
-					     BRASERO_BURN_ERROR,
-					     BRASERO_BURN_ERROR_GENERAL,
-					     _("Data could not be written (%s)"),
-					     g_strerror (errsv));
-				return BRASERO_BURN_ERR;
-			}
+	return BRASERO_BURN_OK;
+}
+
+/* Duplicates what is available in the input pipe to the output pipe without
+ * copying it to user space and then reads it to hash it. Returns
+ * BRASERO_BURN_NOT_SUPPORTED when one of the descriptors is not a pipe. */
+static BraseroBurnResult
+brasero_checksum_image_tee (BraseroChecksumImage *self,
+			    int fd_in,
+			    int fd_out,
+			    guchar *buffer,
+			    gint *bytes,
+			    GError **error)
+{
+	BraseroBurnResult result;
+	gsize copied = 0;
+	gint read_bytes;
+
+	do {
+		result = brasero_job_io_tee (fd_in,
+					     fd_out,
+					     BRASERO_CHECKSUM_IMAGE_BUFFER_SIZE,
+					     &copied,
+					     error);
+		if (brasero_checksum_image_stopped (self))
+			return BRASERO_BURN_CANCEL;
+	} while (result == BRASERO_BURN_RETRY);
+
+	if (result != BRASERO_BURN_OK)
+		return result;
+
+	if (!copied) {
+		*bytes = 0;
+		return BRASERO_BURN_OK;
+	}
+
+	/* The data duplicated is already in the pipe so the whole of it is
+	 * read at once. Nothing must be left behind or it would be teed a
+	 * second time. */
+	read_bytes = brasero_checksum_image_read (self,
+						  fd_in,
+						  buffer,
+						  copied,
+						  error);
+	if (read_bytes == -2)
+		return BRASERO_BURN_CANCEL;
+
+	if (read_bytes == -1)
+		return BRASERO_BURN_ERR;
+
+	*bytes = read_bytes;
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_checksum_image_free_checksums (BraseroChecksumImage *self)
+{
+	BraseroChecksumImagePrivate *priv;
+	guint i;
+
+	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
+
+	for (i = 0; i < BRASERO_CHECKSUM_IMAGE_ALGO_NUM; i ++) {
+		if (priv->checksums [i]) {
+			g_checksum_free (priv->checksums [i]);
+			priv->checksums [i] = NULL;
 		}
+	}
+}
+
+static void
+brasero_checksum_image_update_checksums (BraseroChecksumImage *self,
+					 const guchar *buffer,
+					 gsize bytes)
+{
+	BraseroChecksumImagePrivate *priv;
+	guint i;
+
+	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
 
-		g_usleep (500);
+	for (i = 0; i < BRASERO_CHECKSUM_IMAGE_ALGO_NUM; i ++)
+		g_checksum_update (priv->checksums [i], buffer, bytes);
+}
+
+static guchar *
+brasero_checksum_image_buffer_new (gsize size,
+				   GError **error)
+{
+	gpointer buffer = NULL;
+	int res;
+
+	/* Page aligned so that the kernel can copy it efficiently */
+	res = posix_memalign (&buffer, sysconf (_SC_PAGESIZE), size);
+	if (res) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("Data could not be read (%s)"),
+			     g_strerror (res));
+		return NULL;
+	}
+
+	return buffer;
+}
+
+static void
+brasero_checksum_image_ring_free (BraseroChecksumImage *self)
+{
+	BraseroChecksumImagePrivate *priv;
+	guint i;
 
-		if (written > 0) {
-			bytes_remaining -= written;
-			bytes_written += written;
+	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
+
+	for (i = 0; i < BRASERO_CHECKSUM_IMAGE_RING_SIZE; i ++) {
+		if (priv->ring [i].data) {
+			free (priv->ring [i].data);
+			priv->ring [i].data = NULL;
 		}
+		priv->ring [i].bytes = 0;
 	}
 
+	if (priv->reader_error) {
+		g_error_free (priv->reader_error);
+		priv->reader_error = NULL;
+	}
+}
+
+static BraseroBurnResult
+brasero_checksum_image_ring_new (BraseroChecksumImage *self,
+				 GError **error)
+{
+	BraseroChecksumImagePrivate *priv;
+	guint i;
+
+	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
+
+	for (i = 0; i < BRASERO_CHECKSUM_IMAGE_RING_SIZE; i ++) {
+		priv->ring [i].data = brasero_checksum_image_buffer_new (BRASERO_CHECKSUM_IMAGE_BUFFER_SIZE, error);
+		if (!priv->ring [i].data) {
+			brasero_checksum_image_ring_free (self);
+			return BRASERO_BURN_ERR;
+		}
+		priv->ring [i].bytes = 0;
+		priv->ring [i].teed = FALSE;
+	}
+
+	priv->ring_head = 0;
+	priv->ring_tail = 0;
+	priv->ring_filled = 0;
+	priv->reader_stalls = 0;
+	priv->hasher_stalls = 0;
+	priv->last_stalls = 0;
+	priv->reader_result = BRASERO_BURN_OK;
+	priv->reader_done = FALSE;
+	g_atomic_int_set (&priv->reader_abort, FALSE);
+
 	return BRASERO_BURN_OK;
 }
 
+static gpointer
+brasero_checksum_image_reader_thread (gpointer data)
+{
+	BraseroChecksumImage *self = BRASERO_CHECKSUM_IMAGE (data);
+	BraseroChecksumImagePrivate *priv;
+	GError *error = NULL;
+	int fd_in;
+
+	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
+
+	fd_in = priv->reader_fd;
+
+	while (1) {
+		BraseroChecksumImageBuffer *buffer;
+		gint read_bytes;
+
+		/* Wait for a free buffer */
+		g_mutex_lock (priv->ring_mutex);
+		if (priv->ring_filled == BRASERO_CHECKSUM_IMAGE_RING_SIZE && !priv->reader_abort) {
+			priv->reader_stalls ++;
+			while (priv->ring_filled == BRASERO_CHECKSUM_IMAGE_RING_SIZE && !priv->reader_abort)
+				g_cond_wait (priv->ring_cond, priv->ring_mutex);
+		}
+
+		if (priv->reader_abort) {
+			g_mutex_unlock (priv->ring_mutex);
+			priv->reader_result = BRASERO_BURN_CANCEL;
+			break;
+		}
+
+		buffer = priv->ring + priv->ring_head;
+		g_mutex_unlock (priv->ring_mutex);
+
+		/* This buffer is only ours until it is queued */
+		buffer->teed = FALSE;
+		if (priv->tee_fd > 0) {
+			BraseroBurnResult result;
+
+			result = brasero_checksum_image_tee (self,
+							     fd_in,
+							     priv->tee_fd,
+							     buffer->data,
+							     &read_bytes,
+							     &error);
+			if (result == BRASERO_BURN_NOT_SUPPORTED) {
+				BRASERO_JOB_LOG (self, "tee () not supported, copying data");
+				priv->tee_fd = -1;
+			}
+			else if (result == BRASERO_BURN_CANCEL)
+				read_bytes = -2;
+			else if (result != BRASERO_BURN_OK)
+				read_bytes = -1;
+			else
+				buffer->teed = TRUE;
+		}
+
+		if (priv->tee_fd <= 0)
+			read_bytes = brasero_checksum_image_read (self,
+								  fd_in,
+								  buffer->data,
+								  BRASERO_CHECKSUM_IMAGE_BUFFER_SIZE,
+								  &error);
+		if (read_bytes == -2) {
+			priv->reader_result = BRASERO_BURN_CANCEL;
+			break;
+		}
+
+		if (read_bytes == -1) {
+			priv->reader_result = BRASERO_BURN_ERR;
+			priv->reader_error = error;
+			break;
+		}
+
+		if (!read_bytes) {
+			priv->reader_result = BRASERO_BURN_OK;
+			break;
+		}
+
+		buffer->bytes = read_bytes;
+
+		g_mutex_lock (priv->ring_mutex);
+		priv->ring_head = (priv->ring_head + 1) % BRASERO_CHECKSUM_IMAGE_RING_SIZE;
+		priv->ring_filled ++;
+		g_cond_signal (priv->ring_cond);
+		g_mutex_unlock (priv->ring_mutex);
+	}
+
+	g_mutex_lock (priv->ring_mutex);
+	priv->reader_done = TRUE;
+	g_cond_signal (priv->ring_cond);
+	g_mutex_unlock (priv->ring_mutex);
+
+	return NULL;
+}
+
 static BraseroBurnResult
 brasero_checksum_image_checksum (BraseroChecksumImage *self,
-				 GChecksumType checksum_type,
 				 int fd_in,
 				 int fd_out,
 				 GError **error)
 {
-	gint read_bytes;
-	guchar buffer [2048];
+	GThread *reader;
 	BraseroBurnResult result;
 	BraseroChecksumImagePrivate *priv;
+	guint i;
 
 	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
 
-	priv->checksum = g_checksum_new (checksum_type);
+	result = brasero_checksum_image_ring_new (self, error);
+	if (result != BRASERO_BURN_OK)
+		return result;
+
+	for (i = 0; i < BRASERO_CHECKSUM_IMAGE_ALGO_NUM; i ++)
+		priv->checksums [i] = g_checksum_new (brasero_checksum_image_algos [i].checksum_type);
+
+	if (!priv->timer)
+		priv->timer = g_timer_new ();
+	else
+		g_timer_start (priv->timer);
+
+	/* The reader thread fills the ring while this thread (which will
+	 * hash the data) empties it. That way reading and hashing overlap. */
+	priv->reader_fd = fd_in;
+	priv->tee_fd = fd_out;
+	reader = g_thread_create (brasero_checksum_image_reader_thread,
+				  self,
+				  TRUE,
+				  error);
+	if (!reader) {
+		brasero_checksum_image_ring_free (self);
+		return BRASERO_BURN_ERR;
+	}
+
 	result = BRASERO_BURN_OK;
 	while (1) {
-		read_bytes = brasero_checksum_image_read (self,
-							  fd_in,
-							  buffer,
-							  sizeof (buffer),
-							  error);
-		if (read_bytes == -2)
-			return BRASERO_BURN_CANCEL;
-
-		if (read_bytes == -1)
-			return BRASERO_BURN_ERR;
+		BraseroChecksumImageBuffer *buffer;
+
+		/* Wait for a buffer to be filled */
+		g_mutex_lock (priv->ring_mutex);
+		if (!priv->ring_filled && !priv->reader_done) {
+			priv->hasher_stalls ++;
+			while (!priv->ring_filled && !priv->reader_done)
+				g_cond_wait (priv->ring_cond, priv->ring_mutex);
+		}
 
-		if (!read_bytes)
+		if (!priv->ring_filled) {
+			/* The reader has stopped and everything was hashed */
+			g_mutex_unlock (priv->ring_mutex);
 			break;
+		}
+
+		buffer = priv->ring + priv->ring_tail;
+		g_mutex_unlock (priv->ring_mutex);
 
 		/* it can happen when we're just asked to generate a checksum
 		 * that we don't need to output the received data */
-		if (fd_out > 0) {
+		if (fd_out > 0 && !buffer->teed) {
 			result = brasero_checksum_image_write (self,
 							       fd_out,
-							       buffer,
-							       read_bytes, error);
+							       buffer->data,
+							       buffer->bytes,
+							       error);
 			if (result != BRASERO_BURN_OK)
 				break;
 		}
 
-		g_checksum_update (priv->checksum,
-				   buffer,
-				   read_bytes);
+		brasero_checksum_image_update_checksums (self, buffer->data, buffer->bytes);
+		priv->bytes += buffer->bytes;
 
-		priv->bytes += read_bytes;
+		/* Give the buffer back to the reader */
+		g_mutex_lock (priv->ring_mutex);
+		priv->ring_tail = (priv->ring_tail + 1) % BRASERO_CHECKSUM_IMAGE_RING_SIZE;
+		priv->ring_filled --;
+		g_cond_signal (priv->ring_cond);
+		g_mutex_unlock (priv->ring_mutex);
 	}
 
+	/* Stop the reader if we stopped first because of an error */
+	g_mutex_lock (priv->ring_mutex);
+	g_atomic_int_set (&priv->reader_abort, TRUE);
+	g_cond_signal (priv->ring_cond);
+	g_mutex_unlock (priv->ring_mutex);
+
+	g_thread_join (reader);
+
+	BRASERO_JOB_LOG (self,
+			 "Checksum pipeline stopped (reader stalled %i times, hasher stalled %i times)",
+			 priv->reader_stalls,
+			 priv->hasher_stalls);
+
+	if (result == BRASERO_BURN_OK && priv->reader_result != BRASERO_BURN_OK) {
+		result = priv->reader_result;
+		if (priv->reader_error) {
+			g_propagate_error (error, priv->reader_error);
+			priv->reader_error = NULL;
+		}
+	}
+
+	brasero_checksum_image_ring_free (self);
 	return result;
 }
 
 static BraseroBurnResult
 brasero_checksum_image_checksum_fd_input (BraseroChecksumImage *self,
-					  GChecksumType checksum_type,
 					  GError **error)
 {
 	int fd_in = -1;
@@ -260,12 +624,11 @@ brasero_checksum_image_checksum_fd_input (BraseroChecksumImage *self,
 	brasero_job_get_fd_in (BRASERO_JOB (self), &fd_in);
 	brasero_job_get_fd_out (BRASERO_JOB (self), &fd_out);
 
-	return brasero_checksum_image_checksum (self, checksum_type, fd_in, fd_out, error);
+	return brasero_checksum_image_checksum (self, fd_in, fd_out, error);
 }
 
 static BraseroBurnResult
 brasero_checksum_image_checksum_file_input (BraseroChecksumImage *self,
-					    GChecksumType checksum_type,
 					    GError **error)
 {
 	BraseroChecksumImagePrivate *priv;
@@ -321,7 +684,7 @@ brasero_checksum_image_checksum_file_input (BraseroChecksumImage *self,
 
 	/* and here we go */
 	brasero_job_get_fd_out (BRASERO_JOB (self), &fd_out);
-	result = brasero_checksum_image_checksum (self, checksum_type, fd_in, fd_out, error);
+	result = brasero_checksum_image_checksum (self, fd_in, fd_out, error);
 	g_free (path);
 	close (fd_in);
 
@@ -334,21 +697,15 @@ brasero_checksum_image_create_checksum (BraseroChecksumImage *self,
 {
 	BraseroBurnResult result;
 	BraseroTrack *track = NULL;
-	GChecksumType checksum_type;
 	BraseroChecksumImagePrivate *priv;
 
 	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
 
-	/* get the checksum type */
+	/* check the checksum type */
 	switch (priv->checksum_type) {
 		case BRASERO_CHECKSUM_MD5:
-			checksum_type = G_CHECKSUM_MD5;
-			break;
 		case BRASERO_CHECKSUM_SHA1:
-			checksum_type = G_CHECKSUM_SHA1;
-			break;
 		case BRASERO_CHECKSUM_SHA256:
-			checksum_type = G_CHECKSUM_SHA256;
 			break;
 		default:
 			return BRASERO_BURN_ERR;
@@ -400,7 +757,7 @@ brasero_checksum_image_create_checksum (BraseroChecksumImage *self,
 		/* That's the only way to get the sector size */
 		priv->total *= bytes / sectors;
 
-		return brasero_checksum_image_checksum_fd_input (self, checksum_type, error);
+		return brasero_checksum_image_checksum_fd_input (self, error);
 	}
 	else {
 		result = brasero_track_get_size (track,
@@ -409,7 +766,7 @@ brasero_checksum_image_create_checksum (BraseroChecksumImage *self,
 		if (result != BRASERO_BURN_OK)
 			return result;
 
-		return brasero_checksum_image_checksum_file_input (self, checksum_type, error);
+		return brasero_checksum_image_checksum_file_input (self, error);
 	}
 
 	return BRASERO_BURN_OK;
@@ -433,7 +790,6 @@ brasero_checksum_image_image_and_checksum (BraseroChecksumImage *self,
 					   GError **error)
 {
 	BraseroBurnResult result;
-	GChecksumType checksum_type;
 	BraseroChecksumImagePrivate *priv;
 
 	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (self);
@@ -441,15 +797,13 @@ brasero_checksum_image_image_and_checksum (BraseroChecksumImage *self,
 	priv->checksum_type = brasero_checksum_get_checksum_type ();
 
 	if (priv->checksum_type & BRASERO_CHECKSUM_MD5)
-		checksum_type = G_CHECKSUM_MD5;
+		priv->checksum_type = BRASERO_CHECKSUM_MD5;
 	else if (priv->checksum_type & BRASERO_CHECKSUM_SHA1)
-		checksum_type = G_CHECKSUM_SHA1;
+		priv->checksum_type = BRASERO_CHECKSUM_SHA1;
 	else if (priv->checksum_type & BRASERO_CHECKSUM_SHA256)
-		checksum_type = G_CHECKSUM_SHA256;
-	else {
-		checksum_type = G_CHECKSUM_MD5;
+		priv->checksum_type = BRASERO_CHECKSUM_SHA256;
+	else
 		priv->checksum_type = BRASERO_CHECKSUM_MD5;
-	}
 
 	brasero_job_set_current_action (BRASERO_JOB (self),
 					BRASERO_BURN_ACTION_CHECKSUM,
@@ -467,14 +821,10 @@ brasero_checksum_image_image_and_checksum (BraseroChecksumImage *self,
 		if (result != BRASERO_BURN_OK)
 			return result;
 
-		result = brasero_checksum_image_checksum_file_input (self,
-								     checksum_type,
-								     error);
+		result = brasero_checksum_image_checksum_file_input (self, error);
 	}
 	else
-		result = brasero_checksum_image_checksum_fd_input (self,
-								   checksum_type,
-								   error);
+		result = brasero_checksum_image_checksum_fd_input (self, error);
 
 	return result;
 }
@@ -491,8 +841,9 @@ brasero_checksum_image_end (gpointer data)
 {
 	BraseroChecksumImage *self;
 	BraseroTrack *track;
-	const gchar *checksum;
+	const gchar *checksum = NULL;
 	BraseroBurnResult result;
+	guint i;
 	BraseroChecksumImagePrivate *priv;
 	BraseroChecksumImageThreadCtx *ctx;
 
@@ -509,9 +860,7 @@ brasero_checksum_image_end (gpointer data)
 		error = ctx->error;
 		ctx->error = NULL;
 
-		g_checksum_free (priv->checksum);
-		priv->checksum = NULL;
-
+		brasero_checksum_image_free_checksums (self);
 		brasero_job_error (BRASERO_JOB (self), error);
 		return FALSE;
 	}
@@ -521,9 +870,25 @@ brasero_checksum_image_end (gpointer data)
 	track = NULL;
 	brasero_job_get_current_track (BRASERO_JOB (self), &track);
 
+	/* Record all the digests computed in the tags of the track */
+	for (i = 0; i < BRASERO_CHECKSUM_IMAGE_ALGO_NUM; i ++) {
+		const gchar *digest;
+
+		digest = g_checksum_get_string (priv->checksums [i]);
+		BRASERO_JOB_LOG (self,
+				 "Digest %s = %s",
+				 brasero_checksum_image_algos [i].tag,
+				 digest);
+		brasero_track_tag_add_string (track,
+					      brasero_checksum_image_algos [i].tag,
+					      digest);
+
+		if (brasero_checksum_image_algos [i].type == priv->checksum_type)
+			checksum = digest;
+	}
+
 	/* Set the checksum for the track and at the same time compare it to a
 	 * potential previous one. */
-	checksum = g_checksum_get_string (priv->checksum);
 	BRASERO_JOB_LOG (self,
 			 "Setting new checksum (type = %i) %s (%s before)",
 			 priv->checksum_type,
@@ -532,8 +897,7 @@ brasero_checksum_image_end (gpointer data)
 	result = brasero_track_set_checksum (track,
 					     priv->checksum_type,
 					     checksum);
-	g_checksum_free (priv->checksum);
-	priv->checksum = NULL;
+	brasero_checksum_image_free_checksums (self);
 
 	if (result != BRASERO_BURN_OK)
 		goto error;
@@ -637,8 +1001,10 @@ brasero_checksum_image_start (BraseroJob *job,
 
 	brasero_job_get_action (job, &action);
 	if (action == BRASERO_JOB_ACTION_SIZE) {
-		/* say we won't write to disc if we're just checksuming "live" */
-		if (brasero_job_get_fd_in (job, NULL) == BRASERO_BURN_OK)
+		/* say we won't write to disc if we're just checksuming "live"
+		 * or if we pass the data we hash on to the recorder */
+		if (brasero_job_get_fd_in (job, NULL) == BRASERO_BURN_OK
+		||  brasero_job_get_fd_out (job, NULL) == BRASERO_BURN_OK)
 			return BRASERO_BURN_NOT_SUPPORTED;
 
 		/* otherwise return an output of 0 since we're not actually 
@@ -706,7 +1072,7 @@ brasero_checksum_image_clock_tick (BraseroJob *job)
 
 	priv = BRASERO_CHECKSUM_IMAGE_PRIVATE (job);
 
-	if (!priv->checksum)
+	if (!priv->checksums [0])
 		return BRASERO_BURN_OK;
 
 	if (!priv->total)
@@ -717,6 +1083,33 @@ brasero_checksum_image_clock_tick (BraseroJob *job)
 				  (gdouble) priv->bytes /
 				  (gdouble) priv->total);
 
+	if (priv->timer) {
+		gdouble elapsed;
+		guint filled;
+		guint stalls;
+
+		elapsed = g_timer_elapsed (priv->timer, NULL);
+		if (elapsed > 0.0)
+			brasero_job_set_rate (job, (gdouble) priv->bytes / elapsed);
+
+		/* Only report the state of the pipeline when one of the
+		 * threads had to wait for the other since the last time */
+		g_mutex_lock (priv->ring_mutex);
+		filled = priv->ring_filled;
+		stalls = priv->reader_stalls + priv->hasher_stalls;
+		g_mutex_unlock (priv->ring_mutex);
+
+		if (stalls != priv->last_stalls) {
+			priv->last_stalls = stalls;
+			BRASERO_JOB_LOG (job,
+					 "Checksum pipeline: %i/%i buffers queued (reader stalled %i times, hasher stalled %i times)",
+					 filled,
+					 BRASERO_CHECKSUM_IMAGE_RING_SIZE,
+					 priv->reader_stalls,
+					 priv->hasher_stalls);
+		}
+	}
+
 	return BRASERO_BURN_OK;
 }
 
@@ -742,10 +1135,7 @@ brasero_checksum_image_stop (BraseroJob *job,
 		priv->end_id = 0;
 	}
 
-	if (priv->checksum) {
-		g_checksum_free (priv->checksum);
-		priv->checksum = NULL;
-	}
+	brasero_checksum_image_free_checksums (BRASERO_CHECKSUM_IMAGE (job));
 
 	return BRASERO_BURN_OK;
 }
@@ -759,6 +1149,9 @@ brasero_checksum_image_init (BraseroChecksumImage *obj)
 
 	priv->mutex = g_mutex_new ();
 	priv->cond = g_cond_new ();
+
+	priv->ring_mutex = g_mutex_new ();
+	priv->ring_cond = g_cond_new ();
 }
 
 static void
@@ -782,10 +1175,7 @@ brasero_checksum_image_finalize (GObject *object)
 		priv->end_id = 0;
 	}
 
-	if (priv->checksum) {
-		g_checksum_free (priv->checksum);
-		priv->checksum = NULL;
-	}
+	brasero_checksum_image_free_checksums (BRASERO_CHECKSUM_IMAGE (object));
 
 	if (priv->mutex) {
 		g_mutex_free (priv->mutex);
@@ -797,6 +1187,21 @@ brasero_checksum_image_finalize (GObject *object)
 		priv->cond = NULL;
 	}
 
+	if (priv->ring_mutex) {
+		g_mutex_free (priv->ring_mutex);
+		priv->ring_mutex = NULL;
+	}
+
+	if (priv->ring_cond) {
+		g_cond_free (priv->ring_cond);
+		priv->ring_cond = NULL;
+	}
+
+	if (priv->timer) {
+		g_timer_destroy (priv->timer);
+		priv->timer = NULL;
+	}
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
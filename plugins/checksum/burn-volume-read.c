@@ -35,8 +35,9 @@
 #include "burn-volume-read.h"
 
 struct _BraseroVolFileHandle {
-	/* 64 is an empirical value based on one of my drives. */
-	guchar buffer [2048 * 64];
+	/* Big enough for the biggest transfer the source accepts; the size of
+	 * each read is tuned by the source itself. */
+	guchar *buffer;
 	guint buffer_max;
 
 	/* position in buffer */
@@ -60,22 +61,43 @@ brasero_volume_file_close (BraseroVolFileHandle *handle)
 	g_slist_free (handle->extents_forward);
 	g_slist_free (handle->extents_backward);
 	brasero_volume_source_close (handle->src);
+	g_free (handle->buffer);
 	g_free (handle);
 }
 
+static gboolean
+brasero_volume_file_read_blocks (BraseroVolFileHandle *handle,
+				 gchar *buffer,
+				 guint blocks)
+{
+	gint64 start;
+
+	/* The source may be shared with other readers */
+	if (BRASERO_VOL_SRC_SEEK (handle->src, handle->position, SEEK_SET, NULL) == -1)
+		return FALSE;
+
+	start = g_get_monotonic_time ();
+	if (!BRASERO_VOL_SRC_READ (handle->src, buffer, blocks, NULL))
+		return FALSE;
+
+	brasero_volume_source_transfer_done (handle->src,
+					     blocks,
+					     g_get_monotonic_time () - start);
+	return TRUE;
+}
+
 static gboolean
 brasero_volume_file_fill_buffer (BraseroVolFileHandle *handle)
 {
 	guint blocks;
 	gboolean result;
 
-	blocks = MIN (sizeof (handle->buffer) / 2048,
+	blocks = MIN (brasero_volume_source_get_transfer (handle->src),
 		      handle->extent_last - handle->position);
 
-	result = BRASERO_VOL_SRC_READ (handle->src,
-				       (char *) handle->buffer,
-				       blocks,
-				       NULL);
+	result = brasero_volume_file_read_blocks (handle,
+						  (char *) handle->buffer,
+						  blocks);
 	if (!result)
 		return FALSE;
 
@@ -88,7 +110,7 @@ brasero_volume_file_fill_buffer (BraseroVolFileHandle *handle)
 				      (handle->extent_size % 2048) :
 				       2048);
 	else
-		handle->buffer_max = sizeof (handle->buffer);
+		handle->buffer_max = blocks * 2048;
 
 	return TRUE;
 }
@@ -136,9 +158,13 @@ brasero_volume_file_open (BraseroVolSrc *src,
 	if (file->isdir)
 		return NULL;
 
+	/* File contents are read straight from the medium; a cache would
+	 * only evict the directory records it holds */
 	handle = g_new0 (BraseroVolFileHandle, 1);
-	handle->src = src;
-	brasero_volume_source_ref (src);
+	handle->src = brasero_volume_source_get_uncached (src);
+	brasero_volume_source_ref (handle->src);
+
+	handle->buffer = g_malloc (brasero_volume_source_get_max_transfer (handle->src) * 2048);
 
 	handle->extents_forward = g_slist_copy (file->specific.file.extents);
 	if (!brasero_volume_file_rewind_real (handle)) {
@@ -341,8 +367,8 @@ brasero_volume_file_open_direct (BraseroVolSrc *src,
 		return NULL;
 
 	handle = g_new0 (BraseroVolFileHandle, 1);
-	handle->src = src;
-	brasero_volume_source_ref (src);
+	handle->src = brasero_volume_source_get_uncached (src);
+	brasero_volume_source_ref (handle->src);
 
 	handle->extents_forward = g_slist_copy (file->specific.file.extents);
 
@@ -371,10 +397,9 @@ start:
 	if (!block2read)
 		return readblocks * 2048;
 
-	result = BRASERO_VOL_SRC_READ (handle->src,
-				       (char *) buffer + readblocks * 2048,
-				       block2read,
-				       NULL);
+	result = brasero_volume_file_read_blocks (handle,
+						  (char *) buffer + readblocks * 2048,
+						  block2read);
 	if (!result)
 		return -1;
 
@@ -47,6 +47,7 @@
 #include "brasero-units.h"
 
 #include "burn-job.h"
+#include "burn-job-io.h"
 #include "brasero-plugin-registration.h"
 #include "burn-dvdcss-private.h"
 #include "burn-volume.h"
@@ -197,34 +198,22 @@ brasero_dvdcss_write_sector_to_fd (BraseroDvdcss *self,
 
 	brasero_job_get_fd_out (BRASERO_JOB (self), &fd);
 	while (bytes_remaining) {
-		gint written;
+		BraseroBurnResult result;
+		gsize written = 0;
 
-		written = write (fd,
-				 ((gchar *) buffer)  + bytes_written,
-				 bytes_remaining);
+		result = brasero_job_io_write (fd,
+					       ((gchar *) buffer) + bytes_written,
+					       bytes_remaining,
+					       &written,
+					       &priv->error);
+		if (result == BRASERO_BURN_ERR)
+			return BRASERO_BURN_ERR;
+
+		bytes_remaining -= written;
+		bytes_written += written;
 
 		if (priv->cancel)
 			break;
-
-		if (written != bytes_remaining) {
-			if (errno != EINTR && errno != EAGAIN) {
-                                int errsv = errno;
-
-				/* unrecoverable error */
-				priv->error = g_error_new (BRASERO_BURN_ERROR,
-							   BRASERO_BURN_ERROR_GENERAL,
-							   _("Data could not be written (%s)"),
-							   g_strerror (errsv));
-				return BRASERO_BURN_ERR;
-			}
-
-			g_thread_yield ();
-		}
-
-		if (written > 0) {
-			bytes_remaining -= written;
-			bytes_written += written;
-		}
 	}
 
 	return BRASERO_BURN_OK;
@@ -347,6 +336,15 @@ brasero_dvdcss_write_image_thread (gpointer data)
 	drive = brasero_track_disc_get_drive (BRASERO_TRACK_DISC (track));
 
 	vol = brasero_volume_source_open_file (brasero_drive_get_device (drive), &priv->error);
+	if (vol) {
+		BraseroVolSrc *cache;
+
+		/* Directory records are read one block at a time */
+		cache = brasero_volume_source_open_cache (vol, BRASERO_VOL_SRC_CACHE_DEFAULT_BLOCKS);
+		brasero_volume_source_close (vol);
+		vol = cache;
+	}
+
 	files = brasero_volume_get_files (vol,
 					  0,
 					  NULL,
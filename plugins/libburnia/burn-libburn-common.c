@@ -415,7 +415,22 @@ brasero_libburn_common_status (BraseroJob *self,
 				brasero_job_set_written_session (self, (gint64) ((gint64) cur_sector * 2048ULL));
 				brasero_job_start_progress (self, FALSE);
 
-				string = g_strdup_printf (_("Writing track %02i"), progress.track + 1);
+				if (ctx->has_fifo && progress.buffer_capacity > 0) {
+					guint drive_fill;
+
+					drive_fill = (progress.buffer_capacity - progress.buffer_available) * 100 / progress.buffer_capacity;
+
+					/* Translators: the first %02i is the track number,
+					 * the two others are fill ratios of the memory
+					 * buffer used by brasero and of the drive buffer */
+					string = g_strdup_printf (_("Writing track %02i (FIFO: %i%%, drive buffer: %i%%)"),
+								  progress.track + 1,
+								  ctx->fifo_fill,
+								  drive_fill);
+				}
+				else
+					string = g_strdup_printf (_("Writing track %02i"), progress.track + 1);
+
 				brasero_job_set_current_action (self,
 								BRASERO_BURN_ACTION_RECORDING,
 								string,
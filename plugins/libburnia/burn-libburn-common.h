@@ -57,8 +57,12 @@ struct _BraseroLibburnCtx {
 
 	GTimer *op_start;
 
+	/* fill ratio (in %) of the FIFO placed before libburn if any */
+	guint fifo_fill;
+
 	guint is_burning:1;
 	guint has_leadin:1;
+	guint has_fifo:1;
 };
 typedef struct _BraseroLibburnCtx BraseroLibburnCtx;
 
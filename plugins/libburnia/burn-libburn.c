@@ -67,12 +67,30 @@ BRASERO_PLUGIN_BOILERPLATE (BraseroLibburn, brasero_libburn, BRASERO_TYPE_JOB, B
 
 #define BRASERO_PVD_SIZE	32ULL * 2048ULL
 
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_KEY_FIFO_SIZE		"libburn-fifo-size"
+#define BRASERO_KEY_FIFO_PREFILL	"libburn-fifo-prefill"
+
+/* The buffer is filled by the source which can be read from the FIFO thread
+ * after the job was stopped; so it is shared by the job and the source and the
+ * last one to release it frees it. */
+struct _BraseroLibburnPvd {
+	gint ref;
+	unsigned char buffer [BRASERO_PVD_SIZE];
+};
+typedef struct _BraseroLibburnPvd BraseroLibburnPvd;
+
 struct _BraseroLibburnPrivate {
 	BraseroLibburnCtx *ctx;
 
 	/* This buffer is used to capture Primary Volume Descriptor for
 	 * for overwrite media so as to "grow" the latter. */
-	unsigned char *pvd;
+	BraseroLibburnPvd *pvd;
+
+	/* FIFO placed between the input pipe and libburn (if any) */
+	struct burn_source *fifo;
+	gint fifo_size;					/* in MiB */
+	gint fifo_prefill;				/* in % */
 
 	guint sig_handler:1;
 };
@@ -97,18 +115,45 @@ struct _BraseroLibburnSrcData {
 
 	/* That's for the primary volume descriptor used for overwrite media */
 	int pvd_size;						/* in blocks */
-	unsigned char *pvd;
+	BraseroLibburnPvd *pvd;
 
 	int read_pvd:1;
 };
 typedef struct _BraseroLibburnSrcData BraseroLibburnSrcData;
 
+static BraseroLibburnPvd *
+brasero_libburn_pvd_new (void)
+{
+	BraseroLibburnPvd *pvd;
+
+	pvd = g_new0 (BraseroLibburnPvd, 1);
+	pvd->ref = 1;
+	return pvd;
+}
+
+static BraseroLibburnPvd *
+brasero_libburn_pvd_ref (BraseroLibburnPvd *pvd)
+{
+	g_atomic_int_inc (&pvd->ref);
+	return pvd;
+}
+
+static void
+brasero_libburn_pvd_unref (BraseroLibburnPvd *pvd)
+{
+	if (g_atomic_int_dec_and_test (&pvd->ref))
+		g_free (pvd);
+}
+
 static void
 brasero_libburn_src_free_data (struct burn_source *src)
 {
 	BraseroLibburnSrcData *data;
 
 	data = src->data;
+	if (data->pvd)
+		brasero_libburn_pvd_unref (data->pvd);
+
 	close (data->fd);
 	g_free (data);
 }
@@ -175,7 +220,7 @@ brasero_libburn_src_read_xt (struct burn_source *src,
 		unsigned char *current_pvd;
 		int i;
 
-		current_pvd = data->pvd + data->pvd_size;
+		current_pvd = data->pvd->buffer + data->pvd_size;
 
 		/* read volume descriptors until we reach the end of the
 		 * buffer or find a volume descriptor set end. */
@@ -204,7 +249,7 @@ brasero_libburn_src_read_xt (struct burn_source *src,
 static struct burn_source *
 brasero_libburn_create_fd_source (int fd,
 				  gint64 size,
-				  unsigned char *pvd)
+				  BraseroLibburnPvd *pvd)
 {
 	struct burn_source *src;
 	BraseroLibburnSrcData *data;
@@ -212,10 +257,9 @@ brasero_libburn_create_fd_source (int fd,
 	data = g_new0 (BraseroLibburnSrcData, 1);
 	data->fd = fd;
 	data->size = size;
-	data->pvd = pvd;
+	if (pvd)
+		data->pvd = brasero_libburn_pvd_ref (pvd);
 
-	/* FIXME: this could be wrapped into a fifo source to get a smoother
-	 * data delivery. But that means another thread ... */
 	src = g_new0 (struct burn_source, 1);
 	src->version = 1;
 	src->refcount = 1;
@@ -228,6 +272,269 @@ brasero_libburn_create_fd_source (int fd,
 	return src;
 }
 
+/**
+ * FIFO source: it sits between the pipe of the job producing the data on the
+ * fly and libburn. A thread keeps it filled so that the drive doesn't run out
+ * of data when the producer is slowed down for a while.
+ * NOTE: burn_fifo_source_new () is not used since libburn only starts its
+ * FIFO thread once writing begins and there is no way (with all the libburn
+ * versions we support) to have it wait for a given fill ratio before the data
+ * is delivered. Counting how many times the drive had to wait for data also
+ * needs the read function. burn_fifo_inquire_status () would only replace
+ * brasero_libburn_fifo_get_fill ().
+ */
+
+/* Read from the input by chunks of 32 blocks */
+#define BRASERO_LIBBURN_FIFO_CHUNK	(32 * 2048)
+
+struct _BraseroLibburnFifo {
+	GMutex *lock;
+	GCond *cond;
+
+	struct burn_source *inp;
+
+	unsigned char *buffer;
+	gsize size;
+	gsize start;
+	gsize filled;
+
+	/* how much must be read before delivering data */
+	gsize prefill;
+
+	/* number of times libburn had to wait for data */
+	guint starved;
+
+	guint prefilled:1;
+	guint eof:1;
+	guint error:1;
+
+	/* the source was freed by libburn / the thread exited. The last one
+	 * frees the structure. That way we never wait for a thread that can
+	 * be blocked reading a pipe. */
+	guint freed:1;
+	guint thread_done:1;
+};
+typedef struct _BraseroLibburnFifo BraseroLibburnFifo;
+
+static void
+brasero_libburn_fifo_free (BraseroLibburnFifo *fifo)
+{
+	if (fifo->inp)
+		burn_source_free (fifo->inp);
+
+	g_cond_free (fifo->cond);
+	g_mutex_free (fifo->lock);
+	g_free (fifo->buffer);
+	g_free (fifo);
+}
+
+static gpointer
+brasero_libburn_fifo_thread (gpointer data)
+{
+	BraseroLibburnFifo *fifo = data;
+	gboolean freed;
+
+	g_mutex_lock (fifo->lock);
+	while (!fifo->freed && !fifo->eof && !fifo->error) {
+		gsize end;
+		gsize len;
+		int bytes;
+
+		if (fifo->filled == fifo->size) {
+			g_cond_wait (fifo->cond, fifo->lock);
+			continue;
+		}
+
+		/* Only fill the free space that is contiguous to the data.
+		 * Since the size of the buffer and the chunks are multiples of
+		 * 2048 the reads are aligned on blocks which the capture of
+		 * the primary volume descriptor relies on. */
+		end = (fifo->start + fifo->filled) % fifo->size;
+		if (end >= fifo->start)
+			len = fifo->size - end;
+		else
+			len = fifo->start - end;
+
+		len = MIN (len, BRASERO_LIBBURN_FIFO_CHUNK);
+
+		/* NOTE: the reader never touches the free space */
+		g_mutex_unlock (fifo->lock);
+		bytes = fifo->inp->read_xt (fifo->inp, fifo->buffer + end, len);
+		g_mutex_lock (fifo->lock);
+
+		if (bytes < 0)
+			fifo->error = 1;
+		else if (!bytes)
+			fifo->eof = 1;
+		else
+			fifo->filled += bytes;
+
+		g_cond_broadcast (fifo->cond);
+	}
+
+	fifo->thread_done = 1;
+	freed = fifo->freed;
+	g_mutex_unlock (fifo->lock);
+
+	if (freed)
+		brasero_libburn_fifo_free (fifo);
+
+	return NULL;
+}
+
+static int
+brasero_libburn_fifo_read_xt (struct burn_source *src,
+			      unsigned char *buffer,
+			      int size)
+{
+	BraseroLibburnFifo *fifo;
+	int total = 0;
+
+	fifo = src->data;
+
+	g_mutex_lock (fifo->lock);
+
+	/* wait for the FIFO to be filled enough before delivering anything */
+	while (!fifo->prefilled
+	&&  fifo->filled < fifo->prefill
+	&& !fifo->eof
+	&& !fifo->error)
+		g_cond_wait (fifo->cond, fifo->lock);
+
+	fifo->prefilled = 1;
+
+	if (fifo->filled < size && !fifo->eof && !fifo->error)
+		fifo->starved ++;
+
+	while (total < size) {
+		gsize len;
+
+		while (!fifo->filled && !fifo->eof && !fifo->error)
+			g_cond_wait (fifo->cond, fifo->lock);
+
+		if (!fifo->filled)
+			break;
+
+		len = MIN (fifo->filled, size - total);
+		len = MIN (len, fifo->size - fifo->start);
+
+		memcpy (buffer + total, fifo->buffer + fifo->start, len);
+		fifo->start = (fifo->start + len) % fifo->size;
+		fifo->filled -= len;
+		total += len;
+
+		g_cond_broadcast (fifo->cond);
+	}
+
+	if (!total && fifo->error)
+		total = -1;
+
+	g_mutex_unlock (fifo->lock);
+	return total;
+}
+
+static off_t
+brasero_libburn_fifo_get_size (struct burn_source *src)
+{
+	BraseroLibburnFifo *fifo;
+
+	fifo = src->data;
+	return fifo->inp->get_size (fifo->inp);
+}
+
+static int
+brasero_libburn_fifo_set_size (struct burn_source *src,
+			       off_t size)
+{
+	BraseroLibburnFifo *fifo;
+
+	fifo = src->data;
+	return fifo->inp->set_size (fifo->inp, size);
+}
+
+static void
+brasero_libburn_fifo_free_data (struct burn_source *src)
+{
+	BraseroLibburnFifo *fifo;
+	gboolean thread_done;
+
+	fifo = src->data;
+
+	g_mutex_lock (fifo->lock);
+	BRASERO_BURN_LOG ("FIFO ran short of data %i times", fifo->starved);
+
+	fifo->freed = 1;
+	thread_done = fifo->thread_done;
+	g_cond_broadcast (fifo->cond);
+	g_mutex_unlock (fifo->lock);
+
+	if (thread_done)
+		brasero_libburn_fifo_free (fifo);
+}
+
+static guint
+brasero_libburn_fifo_get_fill (struct burn_source *src)
+{
+	BraseroLibburnFifo *fifo;
+	guint fill;
+
+	fifo = src->data;
+
+	g_mutex_lock (fifo->lock);
+	fill = fifo->filled * 100 / fifo->size;
+	g_mutex_unlock (fifo->lock);
+
+	return fill;
+}
+
+/**
+ * On success, the reference on inp is owned by the returned source
+ */
+
+static struct burn_source *
+brasero_libburn_create_fifo_source (struct burn_source *inp,
+				    gsize size,
+				    gsize prefill)
+{
+	BraseroLibburnFifo *fifo;
+	struct burn_source *src;
+	unsigned char *buffer;
+	GThread *thread;
+
+	buffer = g_try_malloc (size);
+	if (!buffer)
+		return NULL;
+
+	fifo = g_new0 (BraseroLibburnFifo, 1);
+	fifo->lock = g_mutex_new ();
+	fifo->cond = g_cond_new ();
+	fifo->buffer = buffer;
+	fifo->size = size;
+	fifo->prefill = prefill;
+	fifo->inp = inp;
+
+	thread = g_thread_create (brasero_libburn_fifo_thread,
+				  fifo,
+				  FALSE,
+				  NULL);
+	if (!thread) {
+		fifo->inp = NULL;
+		brasero_libburn_fifo_free (fifo);
+		return NULL;
+	}
+
+	src = g_new0 (struct burn_source, 1);
+	src->version = 1;
+	src->refcount = 1;
+	src->read_xt = brasero_libburn_fifo_read_xt;
+	src->get_size = brasero_libburn_fifo_get_size;
+	src->set_size = brasero_libburn_fifo_set_size;
+	src->free_data = brasero_libburn_fifo_free_data;
+	src->data = fifo;
+
+	return src;
+}
+
 static BraseroBurnResult
 brasero_libburn_add_track (struct burn_session *session,
 			   struct burn_track *track,
@@ -259,7 +566,7 @@ brasero_libburn_add_fd_track (struct burn_session *session,
 			      int fd,
 			      gint mode,
 			      gint64 size,
-			      unsigned char *pvd,
+			      BraseroLibburnPvd *pvd,
 			      GError **error)
 {
 	struct burn_source *src;
@@ -278,12 +585,61 @@ brasero_libburn_add_fd_track (struct burn_session *session,
 	return result;
 }
 
+static BraseroBurnResult
+brasero_libburn_add_fifo_track (BraseroLibburn *self,
+				struct burn_session *session,
+				int fd,
+				gint mode,
+				gint64 size,
+				BraseroLibburnPvd *pvd,
+				GError **error)
+{
+	struct burn_source *src;
+	struct burn_source *fifo;
+	struct burn_track *track;
+	BraseroLibburnPrivate *priv;
+	BraseroBurnResult result;
+
+	priv = BRASERO_LIBBURN_PRIVATE (self);
+
+	src = brasero_libburn_create_fd_source (fd, size, pvd);
+	if (priv->fifo_size > 0) {
+		fifo = brasero_libburn_create_fifo_source (src,
+							   (gsize) priv->fifo_size * 1048576,
+							   (gsize) priv->fifo_size * 1048576 / 100 * priv->fifo_prefill);
+		if (fifo) {
+			BRASERO_JOB_LOG (self,
+					 "Using a %i MiB FIFO (prefilled at %i%%)",
+					 priv->fifo_size,
+					 priv->fifo_prefill);
+
+			/* Keep a reference on the FIFO to report its fill ratio */
+			fifo->refcount ++;
+			priv->fifo = fifo;
+			priv->ctx->has_fifo = TRUE;
+			src = fifo;
+		}
+		else
+			BRASERO_JOB_LOG (self, "FIFO could not be created");
+	}
+
+	track = burn_track_create ();
+	burn_track_define_data (track, 0, 0, 0, mode);
+
+	result = brasero_libburn_add_track (session, track, src, mode, error);
+
+	burn_source_free (src);
+	burn_track_free (track);
+
+	return result;
+}
+
 static BraseroBurnResult
 brasero_libburn_add_file_track (struct burn_session *session,
 				const gchar *path,
 				gint mode,
 				off_t size,
-				unsigned char *pvd,
+				BraseroLibburnPvd *pvd,
 				GError **error)
 {
 	int fd;
@@ -335,12 +691,13 @@ brasero_libburn_setup_session_fd (BraseroLibburn *self,
 						     NULL,
 						     &bytes);
 
-		result = brasero_libburn_add_fd_track (session,
-						       fd,
-						       mode,
-						       bytes,
-						       priv->pvd,
-						       error);
+		result = brasero_libburn_add_fifo_track (self,
+							 session,
+							 fd,
+							 mode,
+							 bytes,
+							 priv->pvd,
+							 error);
 	}
 	else if (brasero_track_type_get_has_stream (type)) {
 		GSList *tracks;
@@ -504,7 +861,7 @@ brasero_libburn_start_record (BraseroLibburn *self,
 	if (flags & (BRASERO_BURN_FLAG_MERGE|BRASERO_BURN_FLAG_APPEND)
 	&&  BRASERO_MEDIUM_RANDOM_WRITABLE (media)
 	&& (media & BRASERO_MEDIUM_HAS_DATA))
-		priv->pvd = g_new0 (unsigned char, BRASERO_PVD_SIZE);
+		priv->pvd = brasero_libburn_pvd_new ();
 
 	result = brasero_libburn_create_disc (self, &priv->ctx->disc, error);
 	if (result != BRASERO_BURN_OK)
@@ -823,8 +1180,15 @@ brasero_libburn_stop (BraseroJob *job,
 		priv->ctx = NULL;
 	}
 
+	if (priv->fifo) {
+		burn_source_free (priv->fifo);
+		priv->fifo = NULL;
+	}
+
+	/* NOTE: the FIFO thread may still be reading the source and capture
+	 * the PVD; the source holds its own reference on it */
 	if (priv->pvd) {
-		g_free (priv->pvd);
+		brasero_libburn_pvd_unref (priv->pvd);
 		priv->pvd = NULL;
 	}
 
@@ -842,6 +1206,10 @@ brasero_libburn_clock_tick (BraseroJob *job)
 	int ret;
 
 	priv = BRASERO_LIBBURN_PRIVATE (job);
+
+	if (priv->fifo)
+		priv->ctx->fifo_fill = brasero_libburn_fifo_get_fill (priv->fifo);
+
 	result = brasero_libburn_common_status (job, priv->ctx);
 
 	if (result != BRASERO_BURN_OK)
@@ -876,7 +1244,7 @@ brasero_libburn_clock_tick (BraseroJob *job)
 	BRASERO_JOB_LOG (job, "Starting to overwrite primary volume descriptor");
 	ret = burn_random_access_write (priv->ctx->drive,
 					0,
-					(char*)priv->pvd,
+					(char*)priv->pvd->buffer,
 					BRASERO_PVD_SIZE,
 					0);
 	if (ret != 1) {
@@ -913,7 +1281,23 @@ brasero_libburn_class_init (BraseroLibburnClass *klass)
 static void
 brasero_libburn_init (BraseroLibburn *obj)
 {
+	GSettings *settings;
+	BraseroLibburnPrivate *priv;
+
+	/* load our "configuration" */
+	priv = BRASERO_LIBBURN_PRIVATE (obj);
+
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+
+	priv->fifo_size = g_settings_get_int (settings, BRASERO_KEY_FIFO_SIZE);
+	if (priv->fifo_size < 0 || priv->fifo_size > 256)
+		priv->fifo_size = 16;
 
+	priv->fifo_prefill = g_settings_get_int (settings, BRASERO_KEY_FIFO_PREFILL);
+	if (priv->fifo_prefill < 0 || priv->fifo_prefill > 100)
+		priv->fifo_prefill = 50;
+
+	g_object_unref (settings);
 }
 
 static void
@@ -930,6 +1314,11 @@ brasero_libburn_finalize (GObject *object)
 		priv->ctx = NULL;
 	}
 
+	if (priv->fifo) {
+		burn_source_free (priv->fifo);
+		priv->fifo = NULL;
+	}
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -966,6 +1355,7 @@ brasero_libburn_export_caps (BraseroPlugin *plugin)
 					       BRASERO_MEDIUM_APPENDABLE|
 					       BRASERO_MEDIUM_CLOSED|
 					       BRASERO_MEDIUM_HAS_DATA;
+	BraseroPluginConfOption *fifo_size, *fifo_prefill;
 	GSList *output;
 	GSList *input;
 
@@ -1087,5 +1477,18 @@ brasero_libburn_export_caps (BraseroPlugin *plugin)
 					BRASERO_BURN_FLAG_FAST_BLANK,
 					BRASERO_BURN_FLAG_NONE);
 
+	/* add some configure options */
+	fifo_size = brasero_plugin_conf_option_new (BRASERO_KEY_FIFO_SIZE,
+						    _("Size of the memory buffer used when writing on the fly (in MiB, 0 to disable):"),
+						    BRASERO_PLUGIN_OPTION_INT);
+	brasero_plugin_conf_option_int_set_range (fifo_size, 0, 256);
+	brasero_plugin_add_conf_option (plugin, fifo_size);
+
+	fifo_prefill = brasero_plugin_conf_option_new (BRASERO_KEY_FIFO_PREFILL,
+						       _("Fill ratio of the memory buffer before writing starts (in %):"),
+						       BRASERO_PLUGIN_OPTION_INT);
+	brasero_plugin_conf_option_int_set_range (fifo_prefill, 0, 100);
+	brasero_plugin_add_conf_option (plugin, fifo_prefill);
+
 	brasero_plugin_register_group (plugin, _(LIBBURNIA_DESCRIPTION));
 }
@@ -49,6 +49,7 @@
 
 #include "burn-libburnia.h"
 #include "burn-job.h"
+#include "burn-job-io.h"
 #include "brasero-units.h"
 #include "brasero-plugin-registration.h"
 #include "burn-libburn-common.h"
@@ -77,6 +78,9 @@ struct _BraseroLibisofsPrivate {
 	GCond *cond;
 	guint thread_id;
 
+	/* Updated atomically by the thread */
+	gint written_sectors;
+
 	guint cancel:1;
 };
 typedef struct _BraseroLibisofsPrivate BraseroLibisofsPrivate;
@@ -85,6 +89,22 @@ typedef struct _BraseroLibisofsPrivate BraseroLibisofsPrivate;
 
 static GObjectClass *parent_class = NULL;
 
+/* Data is copied by chunks of that size */
+#define BRASERO_LIBISOFS_CHUNK_SIZE	(2 * 1024 * 1024)
+
+static void
+brasero_libisofs_report_progress (BraseroLibisofs *self)
+{
+	BraseroLibisofsPrivate *priv;
+	gint written_sectors;
+
+	priv = BRASERO_LIBISOFS_PRIVATE (self);
+
+	written_sectors = g_atomic_int_get (&priv->written_sectors);
+	if (written_sectors)
+		brasero_job_set_written_track (BRASERO_JOB (self), ((gint64) written_sectors) << 11);
+}
+
 static gboolean
 brasero_libisofs_thread_finished (gpointer data)
 {
@@ -94,6 +114,8 @@ brasero_libisofs_thread_finished (gpointer data)
 	priv = BRASERO_LIBISOFS_PRIVATE (self);
 
 	priv->thread_id = 0;
+	brasero_libisofs_report_progress (self);
+
 	if (priv->error) {
 		GError *error;
 
@@ -141,49 +163,70 @@ brasero_libisofs_write_sector_to_fd (BraseroLibisofs *self,
 	priv = BRASERO_LIBISOFS_PRIVATE (self);
 
 	while (bytes_remaining) {
-		gint written;
-
-		written = write (fd,
-				 ((gchar *) buffer) + bytes_written,
-				 bytes_remaining);
+		BraseroBurnResult result;
+		gsize written = 0;
 
 		if (priv->cancel)
 			break;
 
-		if (written != bytes_remaining) {
-			if (errno != EINTR && errno != EAGAIN) {
-                                int errsv = errno;
+		/* Returns BRASERO_BURN_RETRY when the reader did not make
+		 * any room for a while; that's to check for cancellation. */
+		result = brasero_job_io_write (fd,
+					       ((gchar *) buffer) + bytes_written,
+					       bytes_remaining,
+					       &written,
+					       &priv->error);
+		if (result == BRASERO_BURN_ERR)
+			return BRASERO_BURN_ERR;
+
+		bytes_remaining -= written;
+		bytes_written += written;
+	}
 
-				/* unrecoverable error */
-				priv->error = g_error_new (BRASERO_BURN_ERROR,
-							   BRASERO_BURN_ERROR_GENERAL,
-							   _("Data could not be written (%s)"),
-							   g_strerror (errsv));
-				return BRASERO_BURN_ERR;
-			}
+	return BRASERO_BURN_OK;
+}
 
-			g_thread_yield ();
-		}
+/**
+ * libisofs only returns data if it can fill the whole buffer (data at the end
+ * of the image is lost otherwise) so read by big chunks as long as the
+ * remaining size of the image allows it then sector by sector.
+ */
 
-		if (written > 0) {
-			bytes_remaining -= written;
-			bytes_written += written;
-		}
-	}
+static int
+brasero_libisofs_read_chunk (BraseroLibisofs *self,
+			     guchar *buffer,
+			     off_t *remaining,
+			     int *size)
+{
+	BraseroLibisofsPrivate *priv;
+	int read_bytes;
 
-	return BRASERO_BURN_OK;
+	priv = BRASERO_LIBISOFS_PRIVATE (self);
+
+	if (*remaining >= BRASERO_LIBISOFS_CHUNK_SIZE)
+		*size = BRASERO_LIBISOFS_CHUNK_SIZE;
+	else if (*remaining > 0)
+		*size = *remaining;
+	else
+		*size = 2048;
+
+	read_bytes = priv->libburn_src->read_xt (priv->libburn_src, buffer, *size);
+	if (read_bytes > 0)
+		*remaining -= read_bytes;
+
+	return read_bytes;
 }
 
 static void
 brasero_libisofs_write_image_to_fd_thread (BraseroLibisofs *self)
 {
-	const gint sector_size = 2048;
 	BraseroLibisofsPrivate *priv;
-	gint64 written_sectors = 0;
 	BraseroBurnResult result;
-	guchar buf [sector_size];
+	off_t remaining;
 	int read_bytes;
+	guchar *buf;
 	int fd = -1;
+	int size;
 
 	priv = BRASERO_LIBISOFS_PRIVATE (self);
 
@@ -198,24 +241,30 @@ brasero_libisofs_write_image_to_fd_thread (BraseroLibisofs *self)
 	brasero_job_get_fd_out (BRASERO_JOB (self), &fd);
 
 	BRASERO_JOB_LOG (self, "Writing to pipe");
-	read_bytes = priv->libburn_src->read_xt (priv->libburn_src, buf, sector_size);
-	while (read_bytes == sector_size) {
+
+	buf = g_malloc (BRASERO_LIBISOFS_CHUNK_SIZE);
+	remaining = priv->libburn_src->get_size (priv->libburn_src);
+
+	read_bytes = brasero_libisofs_read_chunk (self, buf, &remaining, &size);
+	while (read_bytes == size) {
 		if (priv->cancel)
 			break;
 
 		result = brasero_libisofs_write_sector_to_fd (self,
 							      fd,
 							      buf,
-							      sector_size);
+							      read_bytes);
 		if (result != BRASERO_BURN_OK)
 			break;
 
-		written_sectors ++;
-		brasero_job_set_written_track (BRASERO_JOB (self), written_sectors << 11);
+		/* the progress is reported in clock_tick () */
+		g_atomic_int_add (&priv->written_sectors, read_bytes >> 11);
 
-		read_bytes = priv->libburn_src->read_xt (priv->libburn_src, buf, sector_size);
+		read_bytes = brasero_libisofs_read_chunk (self, buf, &remaining, &size);
 	}
 
+	g_free (buf);
+
 	if (read_bytes == -1 && !priv->error)
 		priv->error = g_error_new (BRASERO_BURN_ERROR,
 					   BRASERO_BURN_ERROR_GENERAL,
@@ -225,13 +274,13 @@ brasero_libisofs_write_image_to_fd_thread (BraseroLibisofs *self)
 static void
 brasero_libisofs_write_image_to_file_thread (BraseroLibisofs *self)
 {
-	const gint sector_size = 2048;
 	BraseroLibisofsPrivate *priv;
-	gint64 written_sectors = 0;
-	guchar buf [sector_size];
+	off_t remaining;
 	int read_bytes;
 	gchar *output;
+	guchar *buf;
 	FILE *file;
+	int size;
 
 	priv = BRASERO_LIBISOFS_PRIVATE (self);
 
@@ -261,12 +310,15 @@ brasero_libisofs_write_image_to_file_thread (BraseroLibisofs *self)
 	priv = BRASERO_LIBISOFS_PRIVATE (self);
 	brasero_job_start_progress (BRASERO_JOB (self), FALSE);
 
-	read_bytes = priv->libburn_src->read_xt (priv->libburn_src, buf, sector_size);
-	while (read_bytes == sector_size) {
+	buf = g_malloc (BRASERO_LIBISOFS_CHUNK_SIZE);
+	remaining = priv->libburn_src->get_size (priv->libburn_src);
+
+	read_bytes = brasero_libisofs_read_chunk (self, buf, &remaining, &size);
+	while (read_bytes == size) {
 		if (priv->cancel)
 			break;
 
-		if (fwrite (buf, 1, sector_size, file) != sector_size) {
+		if (fwrite (buf, 1, read_bytes, file) != read_bytes) {
                         int errsv = errno;
 
 			priv->error = g_error_new (BRASERO_BURN_ERROR,
@@ -279,12 +331,14 @@ brasero_libisofs_write_image_to_file_thread (BraseroLibisofs *self)
 		if (priv->cancel)
 			break;
 
-		written_sectors ++;
-		brasero_job_set_written_track (BRASERO_JOB (self), written_sectors << 11);
+		/* the progress is reported in clock_tick () */
+		g_atomic_int_add (&priv->written_sectors, read_bytes >> 11);
 
-		read_bytes = priv->libburn_src->read_xt (priv->libburn_src, buf, sector_size);
+		read_bytes = brasero_libisofs_read_chunk (self, buf, &remaining, &size);
 	}
 
+	g_free (buf);
+
 	if (read_bytes == -1 && !priv->error)
 		priv->error = g_error_new (BRASERO_BURN_ERROR,
 					   BRASERO_BURN_ERROR_GENERAL,
@@ -348,6 +402,8 @@ brasero_libisofs_create_image (BraseroLibisofs *self,
 
 	iso_set_msgs_severities ("NEVER", "ALL", "brasero (libisofs)");
 
+	priv->written_sectors = 0;
+
 	g_mutex_lock (priv->mutex);
 	priv->thread = g_thread_create (brasero_libisofs_thread_started,
 					self,
@@ -1013,6 +1069,15 @@ brasero_libisofs_stop (BraseroJob *job,
 	return BRASERO_BURN_OK;
 }
 
+static BraseroBurnResult
+brasero_libisofs_clock_tick (BraseroJob *job)
+{
+	/* The thread doesn't report the progress itself: that would be for
+	 * every chunk and from another thread than the main loop. */
+	brasero_libisofs_report_progress (BRASERO_LIBISOFS (job));
+	return BRASERO_BURN_OK;
+}
+
 static void
 brasero_libisofs_class_init (BraseroLibisofsClass *klass)
 {
@@ -1026,6 +1091,7 @@ brasero_libisofs_class_init (BraseroLibisofsClass *klass)
 
 	job_class->start = brasero_libisofs_start;
 	job_class->stop = brasero_libisofs_stop;
+	job_class->clock_tick = brasero_libisofs_clock_tick;
 }
 
 static void
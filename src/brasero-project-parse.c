@@ -36,6 +36,7 @@
 
 #include <libxml/xmlerror.h>
 #include <libxml/xmlwriter.h>
+#include <libxml/xmlreader.h>
 #include <libxml/parser.h>
 #include <libxml/xmlstring.h>
 #include <libxml/uri.h>
@@ -64,46 +65,115 @@ brasero_project_invalid_project_dialog (const char *reason)
 			   GTK_MESSAGE_ERROR);
 }
 
+/**
+ * The project is read with a xmlTextReader so that the whole document is never
+ * held in memory; only the current element is.
+ */
+
+static gint
+_read_next_child (xmlTextReaderPtr reader,
+		  gint depth)
+{
+	/* Move to the next element whose depth is depth. Returns 1 if there is
+	 * one, 0 when the end of the parent element was reached and -1 on
+	 * error. Children of the current element are skipped. */
+	while (1) {
+		gint result;
+
+		result = xmlTextReaderRead (reader);
+		if (result != 1)
+			return result;
+
+		if (xmlTextReaderDepth (reader) < depth)
+			return 0;
+
+		if (xmlTextReaderDepth (reader) == depth
+		&&  xmlTextReaderNodeType (reader) == XML_READER_TYPE_ELEMENT)
+			return 1;
+	}
+
+	return -1;
+}
+
+static gboolean
+_read_has_children (xmlTextReaderPtr reader,
+		    gint *depth)
+{
+	/* NOTE: an empty element (<data/>) has no end element */
+	if (xmlTextReaderIsEmptyElement (reader))
+		return FALSE;
+
+	*depth = xmlTextReaderDepth (reader) + 1;
+	return TRUE;
+}
+
+static gboolean
+_read_name_is (xmlTextReaderPtr reader,
+	       const gchar *name)
+{
+	return !xmlStrcmp (xmlTextReaderConstName (reader), (const xmlChar *) name);
+}
+
+static xmlChar *
+_read_string (xmlTextReaderPtr reader)
+{
+	xmlChar *string;
+
+	/* NOTE: unlike xmlNodeListGetString () this returns "" for an empty
+	 * element (<uri/>); an empty value is invalid, as it always was. */
+	string = xmlTextReaderReadString (reader);
+	if (string && !string [0]) {
+		g_free (string);
+		return NULL;
+	}
+
+	return string;
+}
+
 static GSList *
-_read_graft_point (xmlDocPtr project,
-		   xmlNodePtr graft,
+_read_graft_point (xmlTextReaderPtr reader,
 		   GSList *grafts)
 {
 	BraseroGraftPt *retval;
+	gint result;
+	gint depth;
 
 	retval = g_new0 (BraseroGraftPt, 1);
         grafts = g_slist_prepend (grafts, retval);
-	while (graft) {
-		if (!xmlStrcmp (graft->name, (const xmlChar *) "uri")) {
+	if (!_read_has_children (reader, &depth))
+		return grafts;
+
+	while ((result = _read_next_child (reader, depth)) == 1) {
+		if (_read_name_is (reader, "uri")) {
 			xmlChar *uri;
 
 			if (retval->uri)
 				goto error;
 
-			uri = xmlNodeListGetString (project,
-						    graft->xmlChildrenNode,
-						    1);
+			uri = _read_string (reader);
+			if (!uri)
+				goto error;
+
 			retval->uri = g_uri_unescape_string ((char *)uri, NULL);
 			g_free (uri);
 			if (!retval->uri)
 				goto error;
 		}
-		else if (!xmlStrcmp (graft->name, (const xmlChar *) "path")) {
+		else if (_read_name_is (reader, "path")) {
 			if (retval->path)
 				goto error;
 
-			retval->path = (char *) xmlNodeListGetString (project,
-								      graft->xmlChildrenNode,
-								      1);
+			retval->path = (char *) _read_string (reader);
 			if (!retval->path)
 				goto error;
 		}
-		else if (graft->type == XML_ELEMENT_NODE)
+		else
 			goto error;
-
-		graft = graft->next;
 	}
 
+	if (result < 0)
+		goto error;
+
 	return grafts;
 
 error:
@@ -115,62 +185,62 @@ error:
 }
 
 static BraseroTrack *
-_read_data_track (xmlDocPtr project,
-		  xmlNodePtr item)
+_read_data_track (xmlTextReaderPtr reader)
 {
 	BraseroTrackDataCfg *track;
         GSList *grafts= NULL;
         GSList *excluded = NULL;
+	gint result = 0;
+	gint depth;
 
 	track = brasero_track_data_cfg_new ();
+	if (!_read_has_children (reader, &depth))
+		goto end;
 
-	while (item) {
-		if (!xmlStrcmp (item->name, (const xmlChar *) "graft")) {
-			if (!(grafts = _read_graft_point (project, item->xmlChildrenNode, grafts)))
+	while ((result = _read_next_child (reader, depth)) == 1) {
+		if (_read_name_is (reader, "graft")) {
+			if (!(grafts = _read_graft_point (reader, grafts)))
 				goto error;
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "icon")) {
+		else if (_read_name_is (reader, "icon")) {
 			xmlChar *icon_path;
 
-			icon_path = xmlNodeListGetString (project,
-							  item->xmlChildrenNode,
-							  1);
+			icon_path = _read_string (reader);
 			if (!icon_path)
 				goto error;
 
 			brasero_track_data_cfg_set_icon (track, (gchar *) icon_path, NULL);
                         g_free (icon_path);
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "restored")) {
+		else if (_read_name_is (reader, "restored")) {
 			xmlChar *restored;
 
-			restored = xmlNodeListGetString (project,
-							 item->xmlChildrenNode,
-							 1);
+			restored = _read_string (reader);
 			if (!restored)
 				goto error;
 
                         brasero_track_data_cfg_dont_filter_uri (track, (gchar *) restored);
                         g_free (restored);
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "excluded")) {
+		else if (_read_name_is (reader, "excluded")) {
 			xmlChar *excluded_uri;
 
-			excluded_uri = xmlNodeListGetString (project,
-							     item->xmlChildrenNode,
-							     1);
+			excluded_uri = _read_string (reader);
 			if (!excluded_uri)
 				goto error;
 
 			excluded = g_slist_prepend (excluded, xmlURIUnescapeString ((char*) excluded_uri, 0, NULL));
 			g_free (excluded_uri);
 		}
-		else if (item->type == XML_ELEMENT_NODE)
+		else
 			goto error;
-
-		item = item->next;
 	}
 
+	if (result < 0)
+		goto error;
+
+end:
+
         grafts = g_slist_reverse (grafts);
         excluded = g_slist_reverse (excluded);
         brasero_track_data_set_source (BRASERO_TRACK_DATA (track),
@@ -192,22 +262,23 @@ error:
 }
 
 static BraseroTrack *
-_read_audio_track (xmlDocPtr project,
-		   xmlNodePtr uris,
+_read_audio_track (xmlTextReaderPtr reader,
                    gboolean is_video)
 {
 	BraseroTrackStreamCfg *track;
+	gint result = 0;
+	gint depth;
 
 	track = brasero_track_stream_cfg_new ();
+	if (!_read_has_children (reader, &depth))
+		return BRASERO_TRACK (track);
 
-	while (uris) {
-		if (!xmlStrcmp (uris->name, (const xmlChar *) "uri")) {
+	while ((result = _read_next_child (reader, depth)) == 1) {
+		if (_read_name_is (reader, "uri")) {
 			xmlChar *uri;
                         gchar *unescaped_uri;
 
-			uri = xmlNodeListGetString (project,
-						    uris->xmlChildrenNode,
-						    1);
+			uri = _read_string (reader);
 			if (!uri)
 				goto error;
 
@@ -226,16 +297,14 @@ _read_audio_track (xmlDocPtr project,
 
                         g_free (unescaped_uri);
 		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "silence")) {
+		else if (_read_name_is (reader, "silence")) {
 			gchar *silence;
 
 			/* impossible to have two gaps in a row */
 			if (brasero_track_stream_get_gap (BRASERO_TRACK_STREAM (track)) > 0)
 				goto error;
 
-			silence = (gchar *) xmlNodeListGetString (project,
-								  uris->xmlChildrenNode,
-								  1);
+			silence = (gchar *) _read_string (reader);
 			if (!silence)
 				goto error;
 
@@ -245,12 +314,10 @@ _read_audio_track (xmlDocPtr project,
                                                              g_ascii_strtoull (silence, NULL, 10));
 			g_free (silence);
 		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "start")) {
+		else if (_read_name_is (reader, "start")) {
 			gchar *start;
 
-			start = (gchar *) xmlNodeListGetString (project,
-								uris->xmlChildrenNode,
-								1);
+			start = (gchar *) _read_string (reader);
 			if (!start)
 				goto error;
 
@@ -260,12 +327,10 @@ _read_audio_track (xmlDocPtr project,
                                                              -1);
 			g_free (start);
 		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "end")) {
+		else if (_read_name_is (reader, "end")) {
 			gchar *end;
 
-			end = (gchar *) xmlNodeListGetString (project,
-							      uris->xmlChildrenNode,
-							      1);
+			end = (gchar *) _read_string (reader);
 			if (!end)
 				goto error;
 
@@ -275,13 +340,11 @@ _read_audio_track (xmlDocPtr project,
                                                              -1);
 			g_free (end);
 		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "title")) {
+		else if (_read_name_is (reader, "title")) {
 			xmlChar *title;
 			gchar *unescaped_title;
 
-			title = xmlNodeListGetString (project,
-						      uris->xmlChildrenNode,
-						      1);
+			title = _read_string (reader);
 			if (!title)
 				goto error;
 
@@ -293,13 +356,11 @@ _read_audio_track (xmlDocPtr project,
                                                       unescaped_title);
         		g_free (unescaped_title);
 		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "artist")) {
+		else if (_read_name_is (reader, "artist")) {
 			xmlChar *artist;
                         gchar *unescaped_artist;
 
-			artist = xmlNodeListGetString (project,
-						      uris->xmlChildrenNode,
-						      1);
+			artist = _read_string (reader);
 			if (!artist)
 				goto error;
 
@@ -311,13 +372,11 @@ _read_audio_track (xmlDocPtr project,
                                                       unescaped_artist);
         		g_free (unescaped_artist);
 		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "composer")) {
+		else if (_read_name_is (reader, "composer")) {
 			xmlChar *composer;
                         gchar *unescaped_composer;
 
-			composer = xmlNodeListGetString (project,
-							 uris->xmlChildrenNode,
-							 1);
+			composer = _read_string (reader);
 			if (!composer)
 				goto error;
 
@@ -329,12 +388,10 @@ _read_audio_track (xmlDocPtr project,
                                                       unescaped_composer);
         		g_free (unescaped_composer);
 		}
-		else if (!xmlStrcmp (uris->name, (const xmlChar *) "isrc")) {
+		else if (_read_name_is (reader, "isrc")) {
 			gchar *isrc;
 
-			isrc = (gchar *) xmlNodeListGetString (project,
-							       uris->xmlChildrenNode,
-							       1);
+			isrc = (gchar *) _read_string (reader);
 			if (!isrc)
 				goto error;
 
@@ -343,12 +400,13 @@ _read_audio_track (xmlDocPtr project,
                                                    (gint) g_ascii_strtod (isrc, NULL));
 			g_free (isrc);
 		}
-		else if (uris->type == XML_ELEMENT_NODE)
+		else
 			goto error;
-
-		uris = uris->next;
 	}
 
+	if (result < 0)
+		goto error;
+
 	return BRASERO_TRACK (track);
 
 error:
@@ -358,62 +416,50 @@ error:
 	return NULL;
 }
 
-static gboolean
-_get_tracks (xmlDocPtr project,
-	     xmlNodePtr track_node,
-	     BraseroBurnSession *session)
+static GSList *
+_get_tracks (xmlTextReaderPtr reader)
 {
 	GSList *tracks = NULL;
-	GSList *iter;
+	gint result = 0;
+	gint depth;
 
-	track_node = track_node->xmlChildrenNode;
+	if (!_read_has_children (reader, &depth))
+		goto error;
 
-	while (track_node) {
+	while ((result = _read_next_child (reader, depth)) == 1) {
 		BraseroTrack *newtrack;
 
-		if (!xmlStrcmp (track_node->name, (const xmlChar *) "audio")) {
-			newtrack = _read_audio_track (project, track_node->xmlChildrenNode, FALSE);
+		if (_read_name_is (reader, "audio")) {
+			newtrack = _read_audio_track (reader, FALSE);
 			if (!newtrack)
 				goto error;
 
 			tracks = g_slist_append (tracks, newtrack);
 		}
-		else if (!xmlStrcmp (track_node->name, (const xmlChar *) "data")) {
-			newtrack = _read_data_track (project, track_node->xmlChildrenNode);
+		else if (_read_name_is (reader, "data")) {
+			newtrack = _read_data_track (reader);
 
 			if (!newtrack)
 				goto error;
 
 			tracks = g_slist_append (tracks, newtrack);
 		}
-		else if (!xmlStrcmp (track_node->name, (const xmlChar *) "video")) {
-			newtrack = _read_audio_track (project, track_node->xmlChildrenNode, TRUE);
+		else if (_read_name_is (reader, "video")) {
+			newtrack = _read_audio_track (reader, TRUE);
 
 			if (!newtrack)
 				goto error;
 
 			tracks = g_slist_append (tracks, newtrack);
 		}
-		else if (track_node->type == XML_ELEMENT_NODE)
+		else
 			goto error;
-
-		track_node = track_node->next;
 	}
 
-	if (!tracks)
+	if (result < 0 || !tracks)
 		goto error;
 
-	for (iter = tracks; iter; iter = iter->next) {
-		BraseroTrack *newtrack;
-
-		newtrack = iter->data;
-		brasero_burn_session_add_track (session, newtrack, NULL);
-		g_object_unref (newtrack);
-	}
-
-	g_slist_free (tracks);
-
-	return TRUE;
+	return tracks;
 
 error :
 
@@ -422,7 +468,7 @@ error :
 		g_slist_free (tracks);
 	}
 
-	return FALSE;
+	return NULL;
 }
 
 gboolean
@@ -430,14 +476,15 @@ brasero_project_open_project_xml (const gchar *uri,
 				  BraseroBurnSession *session,
 				  gboolean warn_user)
 {
-	xmlNodePtr track_node = NULL;
+	xmlTextReaderPtr project;
+	GSList *tracks = NULL;
+	GSList *iter;
 	gchar *label = NULL;
 	gchar *cover = NULL;
-	xmlDocPtr project;
-	xmlNodePtr item;
-	gboolean retval;
+	gint result;
 	GFile *file;
 	gchar *path;
+	gint depth;
 
 	file = g_file_new_for_commandline_arg (uri);
 	path = g_file_get_path (file);
@@ -446,7 +493,7 @@ brasero_project_open_project_xml (const gchar *uri,
 		return FALSE;
 
 	/* start parsing xml doc */
-	project = xmlParseFile (path);
+	project = xmlReaderForFile (path, NULL, 0);
     	g_free (path);
 
 	if (!project) {
@@ -457,60 +504,70 @@ brasero_project_open_project_xml (const gchar *uri,
 	}
 
 	/* parses the "header" */
-	item = xmlDocGetRootElement (project);
-	if (!item) {
-	    	if (warn_user)
-			brasero_project_invalid_project_dialog (_("The file is empty"));
+	result = _read_next_child (project, 0);
+	if (result != 1) {
+		xmlFreeTextReader (project);
+
+	    	if (warn_user) {
+			if (!result)
+				brasero_project_invalid_project_dialog (_("The file is empty"));
+			else
+				brasero_project_invalid_project_dialog (_("The project could not be opened"));
+		}
 
-		xmlFreeDoc (project);
 		return FALSE;
 	}
 
-	if (xmlStrcmp (item->name, (const xmlChar *) "braseroproject")
-	||  item->next)
+	if (!_read_name_is (project, "braseroproject")
+	||  !_read_has_children (project, &depth))
 		goto error;
 
-	item = item->children;
-	while (item) {
-		if (!xmlStrcmp (item->name, (const xmlChar *) "version")) {
+	while ((result = _read_next_child (project, depth)) == 1) {
+		if (_read_name_is (project, "version")) {
 			/* simply ignore it */
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "label")) {
-			label = (gchar *) xmlNodeListGetString (project,
-								item->xmlChildrenNode,
-								1);
+		else if (_read_name_is (project, "label")) {
+			label = (gchar *) _read_string (project);
 			if (!(label))
 				goto error;
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "cover")) {
+		else if (_read_name_is (project, "cover")) {
 			xmlChar *escaped;
 
-			escaped = xmlNodeListGetString (project,
-							item->xmlChildrenNode,
-							1);
+			escaped = _read_string (project);
 			if (!escaped)
 				goto error;
 
 			cover = g_uri_unescape_string ((char *) escaped, NULL);
 			g_free (escaped);
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "track")) {
-			if (track_node)
+		else if (_read_name_is (project, "track")) {
+			if (tracks)
 				goto error;
 
-			track_node = item;
+			/* The session is only changed once the whole project
+			 * was read successfully */
+			tracks = _get_tracks (project);
+			if (!tracks)
+				goto error;
 		}
-		else if (item->type == XML_ELEMENT_NODE)
+		else
 			goto error;
-
-		item = item->next;
 	}
 
-	retval = _get_tracks (project, track_node, session);
-	if (!retval)
+	if (result < 0 || !tracks)
 		goto error;
 
-	xmlFreeDoc (project);
+	xmlFreeTextReader (project);
+
+	for (iter = tracks; iter; iter = iter->next) {
+		BraseroTrack *newtrack;
+
+		newtrack = iter->data;
+		brasero_burn_session_add_track (session, newtrack, NULL);
+		g_object_unref (newtrack);
+	}
+	g_slist_free (tracks);
 
         brasero_burn_session_set_label (session, label);
         g_free (label);
@@ -528,7 +585,7 @@ brasero_project_open_project_xml (const gchar *uri,
                 g_free (cover);
         }
 
-        return retval;
+        return TRUE;
 
 error:
 
@@ -537,7 +594,12 @@ error:
 	if (label)
 		g_free (label);
 
-	xmlFreeDoc (project);
+	if (tracks) {
+		g_slist_foreach (tracks, (GFunc) g_object_unref, NULL);
+		g_slist_free (tracks);
+	}
+
+	xmlFreeTextReader (project);
     	if (warn_user)
 		brasero_project_invalid_project_dialog (_("It does not seem to be a valid Brasero project"));
 